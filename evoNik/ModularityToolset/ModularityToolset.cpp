@@ -12,6 +12,8 @@
 //#include "Node.h"
 //#include "Edge.h"
 #include "PartitionEnumerator.h"
+#include "PartitionEvaluator.h"
+#include "PartitionSearch.h"
 
 #include "ModularityToolset.h"
 #define JAE_LINE 
@@ -26,8 +28,10 @@ ModularityToolset::ModularityToolset()
 
     is_node_degree_preprocessed = false;
     is_entropy_preprocessed = false;
+    partitions_evaluated = 0;
 
     X1_and_X0_count         = 0; 
+    transition_weight       = 0;
     X1_and_X0_info          = NULL;
     X1_and_X0_info_PTR      = NULL; 
     MU0_info_PTR            = NULL;
@@ -129,7 +133,7 @@ struct ModularityToolset::X1_X0_info
     size_t                  mu0_id;
     size_t                  mu1_id;
         
-    size_t                  frequency;
+    double                  frequency;
 };
 
 
@@ -163,9 +167,6 @@ void ModularityToolset::preprocessEntropyStructures(const MT_TRANSITION_TABLE&
     JAE_LINE;
     JAE_VAR(is_node_degree_preprocessed);
     JAE_VAR(this);
-    size_t                                  X0_count;
-    size_t                                  X1_count;
-
     unsigned long                   x1;
 
     node_count = transition_table.begin()->second[0].size();
@@ -173,10 +174,9 @@ void ModularityToolset::preprocessEntropyStructures(const MT_TRANSITION_TABLE&
     //      ------------------------------------------------------------------------------- //
     //      Initialize the marginal and joint frequencies from the transition table                 //
     //      ------------------------------------------------------------------------------- //
-    X0_count = transition_table.size();
-        
     X1_frequency.clear();
     X1_and_X0_frequency.clear();
+    transition_weight = 0;
 
     for(MT_TRANSITION_TABLE::const_iterator x0 = transition_table.begin(); 
         x0!=transition_table.end(); ++x0)
@@ -188,9 +188,42 @@ void ModularityToolset::preprocessEntropyStructures(const MT_TRANSITION_TABLE&
             X1_frequency[x1]++;
             X1_and_X0_frequency[x1][x0->first]++;
         }
+        transition_weight += x0->second.size();
     }
 
-    X1_count = X1_frequency.size();
+    preprocessFrequencies();
+}
+
+
+void ModularityToolset::preprocessEntropyStructures(const MT_WEIGHTED_TRANSITION_TABLE& transition_table)
+{
+    //      ------------------------------------------------------------------------------- //
+    //      The weights are the frequencies                                                 //
+    //      ------------------------------------------------------------------------------- //
+    X1_frequency.clear();
+    X1_and_X0_frequency.clear();
+    transition_weight = 0;
+
+    for(MT_WEIGHTED_TRANSITION_TABLE::const_iterator x0 = transition_table.begin(); 
+        x0!=transition_table.end(); ++x0)
+    {
+        for(std::map<size_t, double>::const_iterator x1 = x0->second.begin(); x1 != x0->second.end(); ++x1)
+        {
+            if(x1->second <= 0)
+                continue;
+
+            X1_frequency[x1->first]                 += x1->second;
+            X1_and_X0_frequency[x1->first][x0->first] += x1->second;
+            transition_weight                       += x1->second;
+        }
+    }
+
+    preprocessFrequencies();
+}
+
+
+void ModularityToolset::preprocessFrequencies()
+{
 
 
     //      ------------------------------------------------------------------------------- //
@@ -200,7 +233,7 @@ void ModularityToolset::preprocessEntropyStructures(const MT_TRANSITION_TABLE&
     //      
     //      ------------------------------------------------------------------------------- //
     X1_and_X0_count = 0;
-    for(std::map<unsigned long, std::map<unsigned long, size_t> >::iterator x1 = X1_and_X0_frequency.begin(); 
+    for(std::map<unsigned long, std::map<unsigned long, double> >::iterator x1 = X1_and_X0_frequency.begin(); 
         x1 != X1_and_X0_frequency.end(); ++x1)
     {
         X1_and_X0_count         += x1->second.size();
@@ -227,10 +260,10 @@ void ModularityToolset::preprocessEntropyStructures(const MT_TRANSITION_TABLE&
     {
         X1_X0_info* info;
         size_t e=0;
-        for(std::map<unsigned long, std::map<unsigned long, size_t> >::iterator x1 = X1_and_X0_frequency.begin(); 
+        for(std::map<unsigned long, std::map<unsigned long, double> >::iterator x1 = X1_and_X0_frequency.begin(); 
             x1 != X1_and_X0_frequency.end(); ++x1)
         {
-            for(std::map<unsigned long, size_t>::iterator x0 = x1->second.begin();
+            for(std::map<unsigned long, double>::iterator x0 = x1->second.begin();
                 x0 != x1->second.end(); ++x0)
             {
                 info                                    = &X1_and_X0_info[e];
@@ -295,7 +328,7 @@ MT_JOINT_FREQUENCIES ModularityToolset::jointX0X1Frequencies(const MT_TRANSITION
     {
         size_t X0        = X1_and_X0_info[i].X0;
         size_t X1        = X1_and_X0_info[i].X1;
-        size_t count = X1_and_X0_info[i].frequency;
+        size_t count = size_t(X1_and_X0_info[i].frequency);
 
         if(joint_frequencies.count(X0) && joint_frequencies[X0].count(X1))      joint_frequencies[X0][X1] += count;
         else                                                                                                                            joint_frequencies[X0][X1]  = count;
@@ -489,36 +522,56 @@ MT_ENTROPIES ModularityToolset::entropies(const MT_TRANSITION_TABLE& transition_
 }
 
 
+MT_ENTROPIES ModularityToolset::entropies(const MT_WEIGHTED_TRANSITION_TABLE& transition_table, size_t nodes)
+{
+    node_count = nodes;
+
+    size_t M_state_count    = 1 << node_count;
+
+    preprocessEntropyStructures(transition_table);
+
+    MT_ENTROPIES entropies;
+
+    entropies[0] = node_count;
+    for(size_t M=1; M<M_state_count; ++M)
+    {
+        entropies[M] = entropy(M);
+    }
+
+    cleanUpEntropyStructures();
+
+    return entropies;
+}
+
+
 
 double  ModularityToolset::entropy(     size_t M, const MT_TRANSITION_TABLE& transition_table)
 {
     JAE_LINE;
     JAE_VAR(is_node_degree_preprocessed);
     JAE_VAR(this);
+    if(!is_entropy_preprocessed) 
+    {
+        preprocessEntropyStructures(transition_table);
+    }
+
+    return entropy(M);
+}
+
+
+
+double  ModularityToolset::entropy(size_t M)
+{
     // --------------------------------------------------------     //
     // Initializations
     // --------------------------------------------------------     //
     size_t          mu1_mu0_count;
     size_t          mu1_count;
 
-    if(part_size.size() != (unsigned int)(1 << node_count))
+    if(node_count >= 32 || part_size.size() != (unsigned int)(1 << node_count))
     {
         part_size.clear();
     }
-        
-    if(!is_entropy_preprocessed) 
-    {
-        preprocessEntropyStructures(transition_table);
-    }
-
-    // Compute the number of transitions
-    size_t transition_count = 0;
-
-    for(MT_TRANSITION_TABLE::const_iterator transition= transition_table.begin();
-        transition != transition_table.end(); ++transition)
-    {
-        transition_count += transition->second.size();
-    }
 
     // --------------------------------------------------------     //
     // Store the part size
@@ -527,7 +580,7 @@ double  ModularityToolset::entropy(     size_t M, const MT_TRANSITION_TABLE& tra
     {
         for(size_t b=0; b<node_count; ++b)
         {
-            if(M & (1 << b))
+            if(M & (1UL << b))
                 ++part_size[M];
         }
     }
@@ -550,10 +603,6 @@ double  ModularityToolset::entropy(     size_t M, const MT_TRANSITION_TABLE& tra
     // Sort w.r.t. (mu1, mu0)
     X1_X0_info_PTR_pred X1_X0_pred;
     std::sort(X1_and_X0_info_PTR, X1_and_X0_info_PTR + X1_and_X0_count, X1_X0_pred);
-        
-    // Sort w.r.t. mu0 only
-    MU0_PTR_pred MU0_pred;
-    std::sort(MU0_info_PTR, MU0_info_PTR + X1_and_X0_count, MU0_pred);
 
 
     // -------------------------------------------------------------------- //
@@ -595,8 +644,8 @@ double  ModularityToolset::entropy(     size_t M, const MT_TRANSITION_TABLE& tra
     // -------------------------------------------------------------------- //
     //      Initialize the containers used to compute the entropy
     // -------------------------------------------------------------------- //
-    std::map<size_t, double> F_M1;
-    std::map<size_t, double> JF_M1_and_M0;  // Pointer to the joint frequencies of M1 and M0.
+    std::vector<double> F_M1(mu1_count, 0.0);
+    std::vector<double> JF_M1_and_M0(mu1_mu0_count, 0.0);  // Pointer to the joint frequencies of M1 and M0.
     size_t*                                  M0_M1_to_M1;   // Convert joint (M0 M1) frequency index to marginal (M1) frequency index
 
 
@@ -629,10 +678,7 @@ double  ModularityToolset::entropy(     size_t M, const MT_TRANSITION_TABLE& tra
 
     for(size_t i=0; i<mu1_mu0_count; ++i)
     {
-        assert(F_M1.count(M0_M1_to_M1[i]));
-        assert(JF_M1_and_M0.count(i));
-
-        entropy -= JF_M1_and_M0[i] / double(transition_count) * log(JF_M1_and_M0[i] / F_M1[M0_M1_to_M1[i]]) / log_2;
+        entropy -= JF_M1_and_M0[i] / transition_weight * log(JF_M1_and_M0[i] / F_M1[M0_M1_to_M1[i]]) / log_2;
     }
 
 
@@ -660,10 +706,44 @@ std::vector<MT_PARTITION > ModularityToolset::MIPs(const MT_ENTROPIES& entropies
         part_size[it->first] = partSize(it->first, node_count);
     }
 
+    switch (normalization)
+    {
+    case ENM_KOCH:
+        return enumerateMIPs(entropies, KochNormalization());
+    case ENM_TONONI_BALDUZZI:
+        return enumerateMIPs(entropies, TononiBalduzziNormalization());
+    case ENM_PRODUCT_NORMALIZATION:
+        return enumerateMIPs(entropies, ProductNormalization());
+    case ENM_AVG_NODE_DEGREE:
+        JAE_LINE;
+        JAE_VAR(is_node_degree_preprocessed);
+        JAE_VAR(this);
+        // Throws without the node degree (as soon as there is a partition to compare)
+        if(!is_node_degree_preprocessed && node_count > 1)
+        {
+            MT_PARTITION whole = totalPartition(node_count);
+            whole.insert(whole.begin(), 1);
+            avg_node_degree_ei(&whole[0], node_count, entropies);
+        }
+        return enumerateMIPs(entropies, AvgNodeDegreeNormalization(avg_node_degree));
+    case ENM_NONE:
+        return enumerateMIPs(entropies, NoNormalization());
+    default:
+        std::cerr << "Error in ModularityToolset::MIP(): Unknown normalization method ";
+        std::cerr << normalization << ". Returning the total partition." << std::endl;
+        return std::vector<MT_PARTITION >(1, totalPartition(node_count));
+    }
+}
+
+
+template<class Normalization>
+std::vector<MT_PARTITION > ModularityToolset::enumerateMIPs(const MT_ENTROPIES& entropies,
+                                                            const Normalization& normalization)
+{
     PartitionEnumerator             enumerator(node_count);
     P_uint64                                partition_count = enumerator.partitionCount();
     const unsigned long*    partition       = enumerator.partition();
-      //*source = partition + 1;
+    PartitionEvaluator<Normalization>       evaluator(entropies, node_count, normalization);
     MT_PARTITION                    empty_MIP(node_count, 0);
         
     std::vector<MT_PARTITION > equivalent_MIPs(1, empty_MIP);
@@ -672,44 +752,20 @@ std::vector<MT_PARTITION > ModularityToolset::MIPs(const MT_ENTROPIES& entropies
     double  min_information;
 
     memcpy(&equivalent_MIPs.back()[0], partition+1, node_count * sizeof(unsigned long));
+    evaluator.update(enumerator);
 
     min_information = node_count;
+    partitions_evaluated += partition_count;
 
     // Compute the minimum information partition
-    // P_uint64 last_p = 0;
     for(P_uint64 p=1; p<partition_count; ++p)
     {
-        // Proceed to the next partition
+        // Proceed to the next partition and compute its integrated information
+        // from the parts that changed
         enumerator.nextPartition();
+        evaluator.update(enumerator);
 
-        // Compute its integrated information
-        double ei_norm;
-
-        switch (normalization)
-        {
-        case ENM_KOCH:
-            ei_norm = Koch_ei(partition, node_count, entropies);
-            break;
-        case ENM_TONONI_BALDUZZI:
-            ei_norm = TononiBalduzzi_ei(partition, node_count, entropies);
-            break;
-        case ENM_PRODUCT_NORMALIZATION:
-            ei_norm = product_normalization_ei(partition, node_count, entropies);
-            break;
-        case ENM_AVG_NODE_DEGREE:
-            JAE_LINE;
-            JAE_VAR(is_node_degree_preprocessed);
-            JAE_VAR(this);
-            ei_norm = avg_node_degree_ei(partition, node_count, entropies);
-            break;
-        case ENM_NONE:
-            ei_norm = unNormalized_ei(partition, node_count, entropies);
-            break;
-        default:
-            std::cerr << "Error in ModularityToolset::MIP(): Unknown normalization method ";
-            std::cerr << normalization << ". Returning -1.0." << std::endl;
-            ei_norm =  -1.0;
-        }
+        double ei_norm = evaluator.ei();
 
         // --------------------------------------------------------------------------------     //
         // Keep track of the minimum information partition (MIP):
@@ -737,6 +793,93 @@ std::vector<MT_PARTITION > ModularityToolset::MIPs(const MT_ENTROPIES& entropies
 }
 
 
+struct ModularityToolset::PartEntropies
+{
+    ModularityToolset*  toolset;
+    MT_ENTROPIES        known;
+
+    double operator()(MT_PART M)
+    {
+        MT_ENTROPIES::iterator it = known.find(M);
+        if(it == known.end())
+            it = known.insert(std::make_pair(M, toolset->entropy(M))).first;
+        return it->second;
+    }
+};
+
+
+MT_MIP_SEARCH ModularityToolset::approximateMIP(const MT_TRANSITION_TABLE& transition_table,
+                                                E_NORMALIZATION_METHOD normalization,
+                                                unsigned long budget,
+                                                unsigned int seed)
+{
+    preprocessEntropyStructures(transition_table);
+    MT_MIP_SEARCH search = approximateMIP(normalization, budget, seed);
+    cleanUpEntropyStructures();
+
+    return search;
+}
+
+
+MT_MIP_SEARCH ModularityToolset::approximateMIP(const MT_WEIGHTED_TRANSITION_TABLE& transition_table,
+                                                size_t nodes,
+                                                E_NORMALIZATION_METHOD normalization,
+                                                unsigned long budget,
+                                                unsigned int seed)
+{
+    node_count = nodes;
+    preprocessEntropyStructures(transition_table);
+    MT_MIP_SEARCH search = approximateMIP(normalization, budget, seed);
+    cleanUpEntropyStructures();
+
+    return search;
+}
+
+
+MT_MIP_SEARCH ModularityToolset::approximateMIP(E_NORMALIZATION_METHOD normalization,
+                                                unsigned long budget,
+                                                unsigned int seed)
+{
+    switch (normalization)
+    {
+    case ENM_KOCH:
+        return searchMIP(KochNormalization(), budget, seed);
+    case ENM_TONONI_BALDUZZI:
+        return searchMIP(TononiBalduzziNormalization(), budget, seed);
+    case ENM_PRODUCT_NORMALIZATION:
+        return searchMIP(ProductNormalization(), budget, seed);
+    case ENM_AVG_NODE_DEGREE:
+        // Throws without the node degree
+        if(!is_node_degree_preprocessed && node_count > 1)
+        {
+            unsigned long whole[2] = {1, 0};
+            avg_node_degree_ei(whole, node_count, MT_ENTROPIES());
+        }
+        return searchMIP(AvgNodeDegreeNormalization(avg_node_degree), budget, seed);
+    case ENM_NONE:
+        return searchMIP(NoNormalization(), budget, seed);
+    default:
+        std::cerr << "Error in ModularityToolset::approximateMIP(): Unknown normalization method ";
+        std::cerr << normalization << ". Returning the total partition." << std::endl;
+        return searchMIP(NoNormalization(), 0, seed);
+    }
+}
+
+
+template<class Normalization>
+MT_MIP_SEARCH ModularityToolset::searchMIP(const Normalization& normalization,
+                                           unsigned long budget,
+                                           unsigned int seed)
+{
+    PartEntropies entropies;
+    entropies.toolset = this;
+
+    PartitionSearch<Normalization, PartEntropies> search(node_count, entropies, normalization, seed);
+
+    return search.run(budget);
+}
+
+
 std::vector<MT_PARTITION >      ModularityToolset::MIPs(const std::vector<size_t>& subset, 
                                                         const MT_ENTROPIES& entropies, 
                                                         E_NORMALIZATION_METHOD normalization)
@@ -771,6 +914,7 @@ std::vector<MT_PARTITION >      ModularityToolset::MIPs(const std::vector<size_t
         toolset.SetAvgNodeDegree(avg_node_degree);
     }
     std::vector<MT_PARTITION > equivalent_subset_mips = toolset.MIPs(reduced_entropies, normalization);
+    partitions_evaluated += toolset.partitions_evaluated;
 
     // 3- Relocate the nodes so that we get (reduced) partitions with valid parts
     for(size_t mip=0; mip<equivalent_subset_mips.size(); mip++)
@@ -873,6 +1017,7 @@ void ModularityToolset::mainComplexes(
         toolset.SetAvgNodeDegree(avg_node_degree);
     }
     std::vector<MT_PARTITION > equivalent_mips = toolset.MIPs(reduced_entropies, normalization);
+    partitions_evaluated += toolset.partitions_evaluated;
 
         
     // 3- Compute <Phi>
@@ -962,6 +1107,7 @@ std::vector<std::vector<size_t> > ModularityToolset::mainComplexes(
         toolset.SetAvgNodeDegree(avg_node_degree);
     }
     std::vector<MT_PARTITION > equivalent_mips = toolset.MIPs(reduced_entropies, normalization);
+    partitions_evaluated += toolset.partitions_evaluated;
 
         
     // 2- Compute <Phi>
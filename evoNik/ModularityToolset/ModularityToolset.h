@@ -32,11 +32,22 @@ typedef std::map<size_t, std::vector<MT_STATE > >    MT_TRANSITION_TABLE;
 typedef std::map<size_t, size_t>                    MT_FREQUENCIES;
 typedef std::map<size_t, MT_FREQUENCIES >            MT_JOINT_FREQUENCIES;
 typedef std::map<size_t, double>                    MT_ENTROPIES;
+typedef std::map<size_t, std::map<size_t, double> > MT_WEIGHTED_TRANSITION_TABLE;    // X0 -> X1 -> weight
+
+// Outcome of an approximate MIP search (see PartitionSearch.h)
+struct MT_MIP_SEARCH
+{
+    MT_PARTITION    MIP;                // Best partition found (its parts, then zeros)
+    double          min_information;    // Its normalized ei
+    double          ei;                 // Its ei (not normalized)
+    unsigned long   visited;            // Number of partitions evaluated
+};
 
 class ModularityToolset
 {
 public:
     std::map<size_t, size_t>                            part_size;                // Give the number of nodes in the i-th part
+    unsigned long                                       partitions_evaluated;     // Partitions enumerated by MIPs (and mainComplexes) so far
 
     ModularityToolset();
     virtual ~ModularityToolset();
@@ -60,6 +71,9 @@ public:
 
     MT_ENTROPIES                                        entropies(const MT_TRANSITION_TABLE& transition_table);
 
+    // Entropies of weighted transitions (e.g. probabilities) instead of counted ones
+    MT_ENTROPIES                                        entropies(const MT_WEIGHTED_TRANSITION_TABLE& transition_table, size_t node_count);
+
     double                                              entropy(size_t M, const MT_TRANSITION_TABLE& transition_table);
 
     std::vector<MT_PARTITION >                          MIPs(  const MT_ENTROPIES& entropies, 
@@ -69,6 +83,19 @@ public:
                                                                 const MT_ENTROPIES& entropies, 
                                                                 E_NORMALIZATION_METHOD normalization = ENM_NONE);
 
+    // Approximate MIP of a network too wide for MIPs (up to 64 nodes), evaluating at most
+    // 'budget' partitions; entropies are worked out for the parts met only
+    MT_MIP_SEARCH                                       approximateMIP( const MT_TRANSITION_TABLE& transition_table,
+                                                                        E_NORMALIZATION_METHOD normalization,
+                                                                        unsigned long budget,
+                                                                        unsigned int seed = 0);
+
+    MT_MIP_SEARCH                                       approximateMIP( const MT_WEIGHTED_TRANSITION_TABLE& transition_table,
+                                                                        size_t node_count,
+                                                                        E_NORMALIZATION_METHOD normalization,
+                                                                        unsigned long budget,
+                                                                        unsigned int seed = 0);
+
     std::pair<std::vector<std::vector<size_t> >,double> mainComplexes(  const MT_PARTITION& MIP, 
                                                                         const MT_ENTROPIES& entropies, 
                                                                         E_NORMALIZATION_METHOD normalization = ENM_NONE);
@@ -98,8 +125,9 @@ private:
     struct MU0_PTR_pred;
 
     std::map<MT_PART, size_t>                        X0_frequency;            // Give F(X0 = x0)
-    std::map<MT_PART, size_t>                        X1_frequency;            // Give F(X1 = x1)
-    std::map<MT_PART, std::map<MT_PART, size_t> >    X1_and_X0_frequency;    // Give F(X1 = x1, X0 = x0)
+    std::map<MT_PART, double>                        X1_frequency;            // Give F(X1 = x1)
+    std::map<MT_PART, std::map<MT_PART, double> >    X1_and_X0_frequency;    // Give F(X1 = x1, X0 = x0)
+    double                                           transition_weight;      // Sum of all F(X1 = x1, X0 = x0)
 
     size_t                                           node_count;
 
@@ -123,6 +151,12 @@ private:
 
     void                                preprocessEntropyStructures(const MT_TRANSITION_TABLE& transition_table_PTR);
 
+    void                                preprocessEntropyStructures(const MT_WEIGHTED_TRANSITION_TABLE& transition_table);
+
+    void                                preprocessFrequencies();
+
+    double                              entropy(size_t M);
+
     void                                cleanUpEntropyStructures();
 
     std::vector<std::vector<size_t> >    mainComplexes( double& highest_phi,
@@ -140,6 +174,24 @@ private:
         E_NORMALIZATION_METHOD normalization);
 
     bool isValidPartition(const MT_PARTITION& P);
+
+    // MIPs with the normalization known at compile time (see PartitionEvaluator.h)
+    template<class Normalization>
+    std::vector<MT_PARTITION >                          enumerateMIPs(  const MT_ENTROPIES& entropies,
+                                                                        const Normalization& normalization);
+
+    // Entropies of the parts met by an approximate search, worked out once
+    struct PartEntropies;
+
+    // approximateMIP over the preprocessed entropy structures
+    MT_MIP_SEARCH                                       approximateMIP( E_NORMALIZATION_METHOD normalization,
+                                                                        unsigned long budget,
+                                                                        unsigned int seed);
+
+    template<class Normalization>
+    MT_MIP_SEARCH                                       searchMIP(  const Normalization& normalization,
+                                                                    unsigned long budget,
+                                                                    unsigned int seed);
 };
 
 // ---------------------------------------------------------------------------
@@ -32,6 +32,9 @@ PartitionEnumerator::PartitionEnumerator(size_t initial_network_size)
     
     untouched_nodes = 0;
     
+    changedParts_list = new size_t[2 * network_size];
+    changedParts_count = 0;
+    
     // The partition is undefined. Let's position ourselves on the first partition
     firstPartition();
 }
@@ -45,6 +48,7 @@ PartitionEnumerator::~PartitionEnumerator()
     if(nodePos_list) delete[] nodePos_list;
     if(partitionIncrease_list) delete[] partitionIncrease_list;
     if(availablePaths_list) delete[] availablePaths_list;
+    if(changedParts_list) delete[] changedParts_list;
 }
 
 
@@ -115,6 +119,15 @@ void PartitionEnumerator::resizeNetwork(size_t new_network_size)
         }
         availablePaths_list = new size_t[network_size];
         
+        
+        if(changedParts_list)
+        { 
+            delete[] changedParts_list;
+            changedParts_list = NULL;
+        }
+        changedParts_list = new size_t[2 * network_size];
+        changedParts_count = 0;
+        
         untouched_nodes = 0;
     }
     
@@ -135,6 +148,26 @@ const unsigned long* PartitionEnumerator::partition()
 }
 
 
+const size_t* PartitionEnumerator::changedParts()
+{
+    return changedParts_list;
+}
+
+
+size_t PartitionEnumerator::changedPartCount()
+{
+    return changedParts_count;
+}
+
+
+void PartitionEnumerator::allPartsChanged()
+{
+    for(size_t pos=0; pos<network_size; ++pos)
+        changedParts_list[pos] = pos + 1;
+    changedParts_count = network_size;
+}
+
+
 void PartitionEnumerator::firstPartition()
 {
     // Initialize the partition:
@@ -165,16 +198,24 @@ void PartitionEnumerator::firstPartition()
     
     // Only 1 node to modify next time
     untouched_nodes = network_size - 1;
+    
+    // Clear the parts left over from an earlier enumeration
+    for(size_t pos=2; pos<network_size+1; ++pos)
+        Partition[pos] = 0;
+    allPartsChanged();
 }
 
 
 void PartitionEnumerator::nextPartition()
 {
+    changedParts_count = 0;
+    
     // Revert the outdated modifications made to the partition
     for(size_t d=untouched_nodes; d<network_size; ++d)
     {
         temp = (int) (network_size - 1 - d + untouched_nodes);
         Partition[nodePos_list[temp]] &= ~(1 << temp); // Remove the current node
+        changedParts_list[changedParts_count++] = nodePos_list[temp];
         Partition[0] -= partitionIncrease_list[temp]; // Update partition size
     }
     
@@ -194,6 +235,7 @@ void PartitionEnumerator::nextPartition()
             // Equivalent to partition.push_back(1 << d)
             Partition[0]++;
             Partition[Partition[0]] = 1 << d;
+            changedParts_list[changedParts_count++] = Partition[0];
             
             // Track the changes in the partition so that we can revert them later
             partitionIncrease_list[d] = 1; // The partition grew by 1
@@ -208,6 +250,7 @@ void PartitionEnumerator::nextPartition()
             
             // Add the new node to an existing part
             Partition[usedPaths_list[d]+1] |= (1 << d);
+            changedParts_list[changedParts_count++] = usedPaths_list[d]+1;
             
             // Track the changes in the partition so that we can revert them later
             partitionIncrease_list[d] = 0; // The partition hasn't grown
@@ -309,6 +352,9 @@ void PartitionEnumerator::resetPartition(const unsigned long* newPartition)
             }
         }
     }
+    // Clear the parts left over from an earlier enumeration
+    for(size_t p=newPartition[0]+1; p<network_size+1; ++p)
+        Partition[p] = 0;
     // Complete the processing on each node.
     partitionSize_list[0] = 1; // Partition has 1 part (i.e. size = 1)
     partitionIncrease_list[0] = 1; // Partition has increased by 1 (from zero to 1)
@@ -380,6 +426,8 @@ void PartitionEnumerator::resetPartition(const unsigned long* newPartition)
             }
         }
     }
+    
+    allPartsChanged();
 }
 
 
@@ -391,6 +439,8 @@ void PartitionEnumerator::resetPartition(const double* newPartition)
     partitionSize_list[0] = 1; // Partition has 1 part (i.e. size = 1)
     Partition[0] = 1; // Partition has size 1 (contains node zero)
     Partition[1] = 1; // First part contains node 1
+    for(size_t pos=2; pos<network_size+1; ++pos)
+        Partition[pos] = 0;
     nodePos_list[0] = 1; // First node is always in the first part
     partitionIncrease_list[0] = 1; // Partition has increased by 1 (from zero to 1)
     availablePaths_list[0] = 1; // Two paths available from first node, which index grunt up to 1
@@ -469,6 +519,8 @@ void PartitionEnumerator::resetPartition(const double* newPartition)
             }
         }
     }
+    
+    allPartsChanged();
 }
 
 
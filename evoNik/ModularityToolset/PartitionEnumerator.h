@@ -15,10 +15,13 @@ private:
  size_t* nodePos_list; // Used to remove the node from the right part
  size_t* partitionIncrease_list; // Used to recover the partition size (result[0])
  size_t untouched_nodes; // Number of nodes that don't need processing
+ size_t* changedParts_list; // Parts (positions in Partition) written since the previous partition, may repeat
+ size_t changedParts_count; // Number of entries in changedParts_list
 
  int temp;
 
  bool isValidPartition(const unsigned long* partition);
+ void allPartsChanged();
 
 public:
 #ifdef _MSC_VER
@@ -45,6 +48,12 @@ public:
  void randomPartition(unsigned long* randomPartition);
  void resetPartition(const unsigned long* newPartition);
  void resetPartition(const double* newPartition);
+ // ---------------------------------------------------------------------------------------------------------------------------
+ // Positions (1 to network size) of the parts that may differ from the previous partition. Parts past the 1st entry of the
+ // partition are zero. After firstPartition() and resetPartition(), all positions are listed.
+ // ---------------------------------------------------------------------------------------------------------------------------
+ const size_t* changedParts();
+ size_t changedPartCount();
 // size_t distance(const unsigned long* first, const unsigned long* second);
 };
 
@@ -0,0 +1,230 @@
+//
+//  PartitionEvaluator.h
+//  evoNik
+//
+//  Effective information of the partitions a PartitionEnumerator goes
+//  through, updated from the parts that changed since the previous
+//  partition (PartitionEnumerator::changedParts) instead of summed over
+//  all of them. The normalization is a template argument (one of the
+//  structs below, matching E_NORMALIZATION_METHOD), so the enumeration
+//  loop of ModularityToolset::MIPs is compiled once per normalization.
+//  Part entropies are held in fixed point: their sum is kept by integer
+//  additions and subtractions and does not drift over the millions of
+//  partitions of a large network.
+//
+
+#ifndef _PARTITION_EVALUATOR_H_
+#define _PARTITION_EVALUATOR_H_
+
+#include <cmath>
+#include <vector>
+#include "ModularityToolset.h"
+#include "PartitionEnumerator.h"
+
+// Fixed point scale of the entropies (2^48: entropies of up to 2^15 bits)
+const double PE_FIXED_POINT = 281474976710656.0;
+
+// ---------------------------------------------------------------------------
+// Number of parts of each size, with the smallest and largest sizes
+// ---------------------------------------------------------------------------
+class PartSizes
+{
+public:
+    void reset(size_t node_count)
+    {
+        count.assign(node_count + 2, 0);
+        smallest_size = node_count + 1;
+        largest_size = 0;
+    }
+
+    void add(size_t size)
+    {
+        ++count[size];
+        if(size < smallest_size) smallest_size = size;
+        if(size > largest_size) largest_size = size;
+    }
+
+    void remove(size_t size)
+    {
+        if(--count[size]) return;
+
+        // The smallest (largest) part is gone: look for the next size up (down)
+        if(size == smallest_size)
+            while(smallest_size < count.size() - 1 && !count[smallest_size]) ++smallest_size;
+        if(size == largest_size)
+            while(largest_size > 0 && !count[largest_size]) --largest_size;
+    }
+
+    size_t smallest() const { return smallest_size; }
+    size_t largest() const { return largest_size; }
+
+private:
+    std::vector<size_t> count;
+    size_t              smallest_size;
+    size_t              largest_size;
+};
+
+// ---------------------------------------------------------------------------
+// Normalizations: told the sizes of the parts entering (add) and leaving
+// (remove) the partition, they normalize the effective information of the
+// total partition (whole, ei = node_count - H) and of a partition of k > 1
+// parts (normalize, ei = sum of the part entropies - H). Same values as the
+// *_ei functions of ModularityToolset.
+// ---------------------------------------------------------------------------
+struct NoNormalization
+{
+    void reset(size_t) {}
+    void add(size_t) {}
+    void remove(size_t) {}
+    double whole(double ei, size_t) const { return ei; }
+    double normalize(double ei, size_t) const { return ei; }
+};
+
+
+// ei / ((k - 1) * size of the smallest part)
+struct TononiBalduzziNormalization
+{
+    PartSizes sizes;
+
+    void reset(size_t node_count) { sizes.reset(node_count); }
+    void add(size_t size) { sizes.add(size); }
+    void remove(size_t size) { sizes.remove(size); }
+    double whole(double ei, size_t node_count) const { return ei / node_count; }
+    double normalize(double ei, size_t k) const { return ei / ((k - 1) * sizes.smallest()); }
+};
+
+
+// ei / product of the part sizes
+struct ProductNormalization
+{
+    P_uint64 product;
+
+    void reset(size_t) { product = 1; }
+    void add(size_t size) { product *= size; }
+    void remove(size_t size) { product /= size; }
+    double whole(double, size_t node_count) const { return node_count; }
+    double normalize(double ei, size_t) const { return ei / product; }
+};
+
+
+// ei / -sum p log2(p), p = part size / node count
+struct KochNormalization
+{
+    std::vector<long long> term;    // -p log2(p) of each part size, fixed point
+    long long              sum;
+
+    void reset(size_t node_count)
+    {
+        term.assign(node_count + 1, 0);
+        for(size_t size=1; size<=node_count; ++size)
+        {
+            double p = double(size) / double(node_count);
+            term[size] = llround(-p * log(p) / log(2.0) * PE_FIXED_POINT);
+        }
+        sum = 0;
+    }
+    void add(size_t size) { sum += term[size]; }
+    void remove(size_t size) { sum -= term[size]; }
+    double whole(double, size_t node_count) const { return node_count; }
+    double normalize(double ei, size_t) const { return ei / (double(sum) / PE_FIXED_POINT); }
+};
+
+
+// ei / (k - the part of the largest part its average degree does not connect
+// to the others), see ModularityToolset::avg_node_degree_ei
+struct AvgNodeDegreeNormalization
+{
+    double    avg_node_degree;
+    size_t    nodes;
+    PartSizes sizes;
+
+    AvgNodeDegreeNormalization(double avg_node_degree) : avg_node_degree(avg_node_degree) {}
+
+    void reset(size_t node_count) { nodes = node_count; sizes.reset(node_count); }
+    void add(size_t size) { sizes.add(size); }
+    void remove(size_t size) { sizes.remove(size); }
+    double whole(double, size_t node_count) const { return node_count; }
+    double normalize(double ei, size_t k) const
+    {
+        size_t largest_part = sizes.largest();
+        double avg_part_size = double(nodes - largest_part) * avg_node_degree;
+
+        return ei / ((largest_part > avg_part_size) ? (k + avg_part_size - largest_part) : k);
+    }
+};
+
+// ---------------------------------------------------------------------------
+// The evaluator
+// ---------------------------------------------------------------------------
+template<class Normalization>
+class PartitionEvaluator
+{
+public:
+    PartitionEvaluator(const MT_ENTROPIES& entropies, size_t node_count,
+                       const Normalization& normalization = Normalization())
+    : node_count(node_count),
+      H(size_t(1) << node_count, 0),
+      part_size(size_t(1) << node_count, 0),
+      parts(node_count + 1, 0),
+      sum(0),
+      normalization(normalization)
+    {
+        // Entropy and size of every part (the empty part has neither)
+        for(MT_ENTROPIES::const_iterator it=entropies.begin(); it!=entropies.end(); ++it)
+        {
+            if(it->first && it->first < H.size())
+                H[it->first] = llround(it->second * PE_FIXED_POINT);
+        }
+        for(size_t M=1; M<part_size.size(); ++M)
+            part_size[M] = part_size[M >> 1] + (M & 1);
+
+        MT_ENTROPIES::const_iterator all = entropies.find(H.size() - 1);
+        whole_entropy = (all != entropies.end()) ? all->second : 0;
+
+        this->normalization.reset(node_count);
+    }
+
+    // Take in the parts the enumerator changed (all of them the first time)
+    void update(PartitionEnumerator& enumerator)
+    {
+        const unsigned long* partition = enumerator.partition();
+        const size_t* changed = enumerator.changedParts();
+        size_t changed_count = enumerator.changedPartCount();
+
+        k = partition[0];
+        for(size_t c=0; c<changed_count; ++c)
+        {
+            MT_PART& part = parts[changed[c]];
+            MT_PART new_part = partition[changed[c]];
+            if(new_part == part)
+                continue;
+
+            sum += H[new_part] - H[part];
+            if(new_part) normalization.add(part_size[new_part]);
+            if(part) normalization.remove(part_size[part]);
+
+            part = new_part;
+        }
+    }
+
+    // Normalized effective information of the current partition
+    double ei() const
+    {
+        if(k == 1)
+            return normalization.whole(node_count - whole_entropy, node_count);
+
+        return normalization.normalize(double(sum - H.back()) / PE_FIXED_POINT, k);
+    }
+
+private:
+    size_t                  node_count;
+    std::vector<long long>  H;              // Entropy of each part, fixed point
+    std::vector<unsigned char> part_size;   // Number of nodes of each part
+    std::vector<MT_PART>    parts;          // Parts of the current partition (at their position in it)
+    size_t                  k;              // Number of parts
+    long long               sum;            // Sum of the entropies of the parts
+    double                  whole_entropy;  // Entropy of the whole network
+    Normalization           normalization;
+};
+
+#endif    // _PARTITION_EVALUATOR_H_
@@ -0,0 +1,299 @@
+//
+//  PartitionSearch.h
+//  evoNik
+//
+//  Approximate MIP of a network too wide to enumerate the partitions of
+//  (Bell(n) of them; up to 64 nodes). Within a budget of evaluated
+//  partitions: first bipartitions, each node cut off on its own and a
+//  steepest descent (one node moved across at a time) from the best of
+//  these cuts and then from random bipartitions, with half the budget;
+//  then simulated annealing over all partitions (one node moved to
+//  another part or to a part of its own) from the best partition found.
+//  The entropies of the parts are asked for as parts come up (Entropy:
+//  part -> entropy, expected to remember them); the normalizations are
+//  those of PartitionEvaluator.h. As for MIPs, the total partition
+//  stands at ei = node count and equally good partitions are broken in
+//  favour of the larger unnormalized ei.
+//
+
+#ifndef _PARTITION_SEARCH_H_
+#define _PARTITION_SEARCH_H_
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "boost/random/mersenne_twister.hpp"
+#include "ModularityToolset.h"
+#include "PartitionEvaluator.h"
+
+template<class Normalization, class Entropy>
+class PartitionSearch
+{
+public:
+    PartitionSearch(size_t node_count, Entropy& entropy, const Normalization& normalization, unsigned int seed)
+    : node_count(node_count),
+      entropy(entropy),
+      normalization(normalization),
+      owner(node_count, 0),
+      random_engine(seed)
+    {
+        all_nodes = (node_count < 64) ? (MT_PART(1) << node_count) - 1 : ~MT_PART(0);
+        whole_entropy = entropy(all_nodes);
+        this->normalization.reset(node_count);
+    }
+
+    MT_MIP_SEARCH run(unsigned long budget)
+    {
+        search.MIP.assign(node_count, 0);
+        search.MIP[0] = all_nodes;
+        search.min_information = node_count;
+        search.ei = node_count - whole_entropy;
+        search.visited = 0;
+        this->budget = budget;
+        if(node_count < 2)
+            return search;
+
+        // ---------------------------------------------------------------------------
+        // Bipartitions: every node cut off, then descents from the best cuts and from
+        // random bipartitions
+        // ---------------------------------------------------------------------------
+        std::vector<std::pair<double, size_t> > cuts;
+        for(size_t node=0; node<node_count && spent() < budget; ++node)
+        {
+            bipartition(MT_PART(1) << node);
+            cuts.push_back(std::make_pair(evaluate(), node));
+        }
+        std::sort(cuts.begin(), cuts.end());
+
+        uphill_sum = 0;
+        uphill_count = 0;
+        for(size_t start=0; spent() < budget / 2; ++start)
+        {
+            if(start < cuts.size())
+                bipartition(MT_PART(1) << cuts[start].second);
+            else
+            {
+                MT_PART side = 0;
+                while(side == 0 || side == all_nodes)
+                    side = randomBits() & all_nodes;
+                bipartition(side);
+            }
+            descend(evaluate());
+        }
+
+        // ---------------------------------------------------------------------------
+        // Simulated annealing from the best partition, the temperature falling from
+        // the average uphill step of the descents to a thousandth of it
+        // ---------------------------------------------------------------------------
+        // (two nodes have a single bipartition)
+        if(spent() >= budget || node_count < 3)
+            return search;
+
+        if(search.MIP[1])
+            load(search.MIP);
+        else
+            bipartition(MT_PART(1) << cuts[0].second);
+        double current = evaluate();
+        double first_temperature = uphill_count ? uphill_sum / uphill_count : 0.001;
+        unsigned long steps = budget - spent();
+
+        for(unsigned long step=0; spent() < budget; ++step)
+        {
+            double temperature = first_temperature * pow(0.001, double(step) / double(steps));
+
+            // A node to another part, or to a part of its own (not to the total partition)
+            size_t node = random_engine() % node_count;
+            size_t from = owner[node];
+            bool alone = (parts[from] == (MT_PART(1) << node));
+            size_t to = random_engine() % parts.size();
+            if(to == from)
+                to = parts.size();
+            if((to == parts.size() && alone) || (alone && parts.size() == 2))
+                continue;
+
+            move(node, to);
+            double value = evaluate();
+            double difference = value - current;
+
+            if(difference <= 0 || double(random_engine()) / 4294967296.0 < exp(-difference / temperature))
+                current = value;
+            else
+                move(node, alone ? parts.size() : from);
+        }
+
+        return search;
+    }
+
+private:
+    size_t                  node_count;
+    Entropy&                entropy;
+    Normalization           normalization;
+    MT_PART                 all_nodes;
+    double                  whole_entropy;
+    std::vector<MT_PART>    parts;          // Parts of the current partition
+    std::vector<double>     part_entropy;   // Their entropies
+    std::vector<size_t>     owner;          // Part of each node
+    boost::mt19937          random_engine;
+    unsigned long           budget;
+    double                  uphill_sum;     // Steps up met by the descents (the scale of the annealing)
+    unsigned long           uphill_count;
+    MT_MIP_SEARCH           search;         // Best partition so far
+
+    unsigned long spent() const { return search.visited; }
+
+    MT_PART randomBits()
+    {
+        return (MT_PART(random_engine()) << 32) | random_engine();
+    }
+
+    static size_t size(MT_PART part)
+    {
+        size_t nodes = 0;
+        for(; part; part &= part - 1) ++nodes;
+        return nodes;
+    }
+
+    // ---------------------------------------------------------------------------
+    // The current partition
+    // ---------------------------------------------------------------------------
+    void clear()
+    {
+        for(size_t part=0; part<parts.size(); ++part)
+            normalization.remove(size(parts[part]));
+        parts.clear();
+        part_entropy.clear();
+    }
+
+    void addPart(MT_PART part)
+    {
+        for(size_t node=0; node<node_count; ++node)
+            if(part & (MT_PART(1) << node)) owner[node] = parts.size();
+        parts.push_back(part);
+        part_entropy.push_back(entropy(part));
+        normalization.add(size(part));
+    }
+
+    void bipartition(MT_PART side)
+    {
+        clear();
+        addPart(side);
+        addPart(all_nodes & ~side);
+    }
+
+    void load(const MT_PARTITION& partition)
+    {
+        clear();
+        for(size_t part=0; part<partition.size() && partition[part]; ++part)
+            addPart(partition[part]);
+    }
+
+    // Move a node to a part (parts.size(): a part of its own); a part left empty
+    // is replaced by the last one
+    void move(size_t node, size_t to)
+    {
+        MT_PART bit = MT_PART(1) << node;
+        size_t from = owner[node];
+
+        normalization.remove(size(parts[from]));
+        parts[from] &= ~bit;
+        if(to == parts.size())
+        {
+            parts.push_back(bit);
+            part_entropy.push_back(entropy(bit));
+            normalization.add(1);
+        }
+        else
+        {
+            normalization.remove(size(parts[to]));
+            parts[to] |= bit;
+            part_entropy[to] = entropy(parts[to]);
+            normalization.add(size(parts[to]));
+        }
+        owner[node] = to;
+
+        if(parts[from])
+        {
+            part_entropy[from] = entropy(parts[from]);
+            normalization.add(size(parts[from]));
+        }
+        else
+        {
+            parts[from] = parts.back();
+            part_entropy[from] = part_entropy.back();
+            parts.pop_back();
+            part_entropy.pop_back();
+            for(size_t n=0; n<node_count; ++n)
+                if(from < parts.size() && (parts[from] & (MT_PART(1) << n))) owner[n] = from;
+        }
+    }
+
+    // Normalized ei of the current partition (kept if the best so far)
+    double evaluate()
+    {
+        double ei = -whole_entropy;
+        for(size_t part=0; part<parts.size(); ++part)
+            ei += part_entropy[part];
+        double ei_norm = normalization.normalize(ei, parts.size());
+
+        search.visited++;
+        double difference = ei_norm - search.min_information;
+        if(difference < -0.0000000001 || (fabs(difference) < 0.0000000001 && ei > search.ei))
+        {
+            std::vector<MT_PART> sorted(parts);
+            std::sort(sorted.begin(), sorted.end(), lowestNodeFirst);
+            search.MIP.assign(node_count, 0);
+            std::copy(sorted.begin(), sorted.end(), search.MIP.begin());
+            search.min_information = ei_norm;
+            search.ei = ei;
+        }
+
+        return ei_norm;
+    }
+
+    static bool lowestNodeFirst(MT_PART a, MT_PART b)
+    {
+        return (a & (~a + 1)) < (b & (~b + 1));
+    }
+
+    // Steepest descent over bipartitions: the best single node moved across, while
+    // it helps
+    void descend(double current)
+    {
+        while(spent() < budget)
+        {
+            double best = current;
+            size_t best_node = node_count;
+
+            for(size_t node=0; node<node_count && spent() < budget; ++node)
+            {
+                size_t from = owner[node];
+                if(parts[from] == (MT_PART(1) << node))
+                    continue;
+
+                // (no side is emptied: both keep their positions)
+                move(node, 1 - from);
+                double value = evaluate();
+                move(node, from);
+
+                if(value > current)
+                {
+                    uphill_sum += value - current;
+                    uphill_count++;
+                }
+                if(value < best - 0.0000000001)
+                {
+                    best = value;
+                    best_node = node;
+                }
+            }
+
+            if(best_node == node_count)
+                return;
+
+            move(best_node, 1 - owner[best_node]);
+            current = best;
+        }
+    }
+};
+
+#endif    // _PARTITION_SEARCH_H_
@@ -0,0 +1,394 @@
+//
+//  bench.cpp
+//  evoNik
+//
+//  Seeded microbenchmarks of the evolution hot paths.
+//  Results are written as JSON: time (ns) and heap allocations per operation.
+//
+//  usage ./evoNikBench [--filter NAME_PART] [--seed N] [--minTime SECONDS] [--output FILE]
+//
+
+#include <new>
+#include <cstdlib>
+
+#include <boost/chrono.hpp>
+
+#include "../utility.hpp"
+#include "../nAgent.hpp"
+#include "../nMaze.hpp"
+#include "../nGame.hpp"
+#include "../nPopulation.hpp"
+#include "../nAnalyzer.hpp"
+#include "../nScheduler.hpp"
+#include "../ModularityToolset/ModularityToolset.h"
+
+
+//// heap allocation counter (all operator new calls of the process)
+static boost::atomic<unsigned long> allocationCount(0);
+
+void* operator new(std::size_t size){
+    allocationCount++;
+    void* p = std::malloc(size ? size : 1);
+    if (p == NULL)
+        throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](std::size_t size){
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept                    { std::free(p); }
+void operator delete[](void* p) noexcept                  { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept       { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept     { std::free(p); }
+
+
+//// benchmark bookkeeping
+struct benchResult{
+    std::string name;
+    unsigned long iterations;
+    double nsPerOp;
+    double allocationsPerOp;
+};
+
+class benchSuite{
+public:
+
+    benchSuite(unsigned int seed, double minTime, std::string filter)
+    : m_seed(seed), m_minTime(minTime), m_filter(filter){
+    }
+
+    // should the named benchmark run?
+    bool selected(const std::string& name){
+        return m_filter.empty() || name.find(m_filter) != std::string::npos;
+    }
+
+    // seed for the set-up of a benchmark
+    unsigned int getSeed(void)                                  { return m_seed; }
+
+    // time op() (repeated for at least minTime seconds and minIterations times)
+    void measure(const std::string& name, boost::function<void()> op, unsigned long minIterations = 1){
+
+        if (!selected(name))
+            return;
+
+        std::cerr << "bench: " << name << std::endl;
+
+        // the operations draw from their own (seeded) random stream
+        nRandomStream randomStream(m_seed);
+
+        typedef boost::chrono::steady_clock clock;
+        unsigned long iterations = 0;
+        unsigned long allocationsBefore = allocationCount;
+        clock::time_point start = clock::now();
+        double elapsed = 0;
+
+        while (iterations < minIterations || elapsed < m_minTime) {
+            op();
+            iterations++;
+            elapsed = boost::chrono::duration<double>(clock::now() - start).count();
+        }
+
+        benchResult result;
+        result.name = name;
+        result.iterations = iterations;
+        result.nsPerOp = elapsed * 1e9 / iterations;
+        result.allocationsPerOp = (double)(allocationCount - allocationsBefore) / iterations;
+        m_results.push_back(result);
+    }
+
+    // write out the results
+    void print(std::ostream& fout){
+        fout << "{" << std::endl
+        << "  \"seed\": " << m_seed << "," << std::endl
+        << "  \"benchmarks\": [" << std::endl;
+        for (size_t i = 0; i < m_results.size(); i++) {
+            fout << "    {\"name\": \"" << m_results[i].name << "\""
+            << ", \"iterations\": " << m_results[i].iterations
+            << ", \"ns_per_op\": " << std::fixed << std::setprecision(1) << m_results[i].nsPerOp
+            << ", \"allocs_per_op\": " << std::setprecision(3) << m_results[i].allocationsPerOp
+            << "}" << ((i + 1 < m_results.size()) ? "," : "") << std::endl;
+        }
+        fout << "  ]" << std::endl << "}" << std::endl;
+    }
+
+private:
+    unsigned int m_seed;
+    double m_minTime;
+    std::string m_filter;
+    std::vector<benchResult> m_results;
+};
+
+
+// a stream that swallows everything (for LOD, knockout and analysis output)
+static std::ostream nullStream(NULL);
+
+
+//// the operations
+static void brainSteps(nAgent* agent, unsigned int steps){
+    for (unsigned int i = 0; i < steps; i++) {
+        agent->m_prevState = agent->m_curState;
+        agent->m_prevHighState = agent->m_curHighState;
+        agent->updateBrain();
+    }
+    agent->m_stateHistory.clear();
+    agent->m_wideStateHistory.clear();
+}
+
+static void executeGame(nGame* game, nAgent* agent){
+    agent->resetBrain();
+    agent->resetFitness();
+    agent->m_trajectory.clear();
+    game->updatePlayer(*agent);
+    game->execute(200);
+}
+
+static void buildBrain(nAgent* agent){
+    agent->buildHMMs();
+}
+
+// a child as reproduce makes it (without the lineage bookkeeping)
+static void childViaMutation(nAgent* parent){
+    nAgent* child = new nAgent(parent->inheriteViaMutation());
+    child->applyDeletion();
+    child->applyInsertion();
+    child->buildHMMs();
+    delete child;
+}
+
+static void childrenViaCrossOver(nAgent* parent, nAgent* partner){
+    std::pair<nAgent, nAgent> kids = parent->crossOver(*partner);
+    nAgent* child1 = new nAgent(std::move(kids.first));
+    nAgent* child2 = new nAgent(std::move(kids.second));
+    child1->mutate();
+    child2->mutate();
+    child1->applyDeletion();
+    child2->applyDeletion();
+    child1->applyInsertion();
+    child2->applyInsertion();
+    child1->buildHMMs();
+    child2->buildHMMs();
+    delete child1;
+    delete child2;
+}
+
+static void buildLandscape(nGame* game, nMaze* maze){
+    game->updatePlayGround(*maze);
+}
+
+static void oneGeneration(std::vector<nPopulation*>* generations, nGame* game){
+    generations->back()->evaluate(*game);
+    generations->push_back(new nPopulation(generations->back()->reproduce()));
+
+    if (generations->front()->getMembers().size() == 0) {
+        delete generations->front();
+        generations->erase(generations->begin());
+    }
+}
+
+static void mutualInfo(nAnalyzer* analyzer){
+    analyzer->calculateMutualInfo(0, 0, 0);
+}
+
+static void minimumInformationPartitions(ModularityToolset* toolset, MT_ENTROPIES* entropies){
+    toolset->MIPs(*entropies, ENM_TONONI_BALDUZZI);
+}
+
+static void mainComplexes(ModularityToolset* toolset, MT_ENTROPIES* entropies, size_t nodes){
+    toolset->mainComplexes(totalPartition(nodes), *entropies, ENM_TONONI_BALDUZZI);
+}
+
+static void approximateMIP(MT_TRANSITION_TABLE* table){
+    ModularityToolset toolset;
+    toolset.approximateMIP(*table, ENM_TONONI_BALDUZZI, 2000);
+}
+
+
+// transition table of a random (but seeded) network of the given size
+static MT_TRANSITION_TABLE randomTransitionTable(size_t nodes, unsigned int seed){
+    nRandomStream randomStream(seed);
+
+    MT_TRANSITION_TABLE table;
+    for (unsigned long state = 0; state < (1UL << nodes); state++)
+        table[state].push_back(MT_STATE(nodes, (state*2654435761UL ^ genRandInt()) & ((1UL << nodes) - 1)));
+
+    return table;
+}
+
+
+// transition table of as many random states of a (seeded) network too wide to list them
+static MT_TRANSITION_TABLE sampledTransitionTable(size_t nodes, unsigned long samples, unsigned int seed){
+    nRandomStream randomStream(seed);
+
+    MT_TRANSITION_TABLE table;
+    unsigned long nodeMask = (nodes < 64) ? (1UL << nodes) - 1 : ~0UL;
+    for (unsigned long i = 0; i < samples; i++) {
+        unsigned long state = (((unsigned long)genRandInt() << 32) | genRandInt()) & nodeMask;
+        // each node driven by two others
+        unsigned long next = ((state << 1) ^ (state >> 3) ^ (genRandInt() % 8 == 0)) & nodeMask;
+        table[state].push_back(MT_STATE(nodes, next));
+    }
+
+    return table;
+}
+
+
+int main(int argc, char* argv[]){
+
+    unsigned int seed;
+    double minTime;
+    std::string filter, outputFile;
+
+    po::options_description options("Benchmark options");
+    options.add_options()
+    ("help,h", "print this message")
+    ("filter", po::value<std::string>(&filter)->default_value(""), "run only benchmarks whose name contains this")
+    ("seed", po::value<unsigned int>(&seed)->default_value(42), "random seed")
+    ("minTime", po::value<double>(&minTime)->default_value(0.5), "minimum time per benchmark (seconds)")
+    ("output", po::value<std::string>(&outputFile), "JSON output file (default: stdout)");
+
+    po::variables_map vm;
+    try {
+        po::store(po::parse_command_line(argc, argv, options), vm);
+        po::notify(vm);
+    } catch (po::error& e) {
+        std::cerr << "Error in bench: " << e.what() << std::endl;
+        return 1;
+    }
+
+    if (vm.count("help")) {
+        std::cerr << options << std::endl;
+        return 0;
+    }
+
+    params.suppressMessages = true;
+
+    benchSuite suite(seed, minTime, filter);
+    nRandomStream setupStream(seed);
+
+    // agents with random (seeded) genomes
+    nAgent agent;
+    agent.setupRandomGenome();
+
+    // maze and game as in a run
+    nMaze maze(params.evaluationTime + 10, 15);
+    nGame game(maze);
+    game.setKnockoutStream(nullStream);
+
+    //// brain
+    suite.measure("brain_step_x1000", boost::bind(&brainSteps, &agent, 1000), 100);
+    suite.measure("buildHMMs", boost::bind(&buildBrain, &agent), 1000);
+
+    // a wide brain (its states in several words)
+    if (suite.selected("brain_step_x1000_128_nodes")) {
+        unsigned int maxNodes = params.maxNodes;
+        params.maxNodes = 128;
+        nAgent wideAgent;
+        {
+            nRandomStream wideStream(seed + 2);
+            wideAgent.setupRandomGenome();
+        }
+        suite.measure("brain_step_x1000_128_nodes", boost::bind(&brainSteps, &wideAgent, 1000), 100);
+        params.maxNodes = maxNodes;
+    }
+
+    //// children (genome allocations and brain builds per child)
+    nAgent partner;
+    {
+        // (its own stream: the set-up of the benchmarks below is not shifted)
+        nRandomStream partnerStream(seed + 1);
+        partner.setupRandomGenome();
+    }
+    suite.measure("child_via_mutation", boost::bind(&childViaMutation, &agent), 1000);
+    suite.measure("children_via_crossover", boost::bind(&childrenViaCrossOver, &agent, &partner), 1000);
+
+    //// game
+    // a deterministic brain: once the game repeats a state, execute skips the cycles
+    // to the end, so this is mostly the steps up to the first repeat
+    suite.measure("execute_200_steps_cycle_skip", boost::bind(&executeGame, &game, &agent), 100);
+    // the same genome as a stochastic brain, which plays all the 200 steps
+    nAgent stochasticAgent(agent.inheriteGenome());
+    {
+        bool deterministic = params.deterministicHMM;
+        params.deterministicHMM = false;
+        stochasticAgent.buildHMMs();
+        params.deterministicHMM = deterministic;
+    }
+    suite.measure("execute_200_steps_stochastic", boost::bind(&executeGame, &game, &stochasticAgent), 100);
+
+    if (suite.selected("fitness_landscape")) {
+        nMaze landscapeMaze(params.evaluationTime + 10, 15);
+        suite.measure("fitness_landscape", boost::bind(&buildLandscape, &game, &landscapeMaze), 10);
+        game.updatePlayGround(maze);
+    }
+
+    //// evolution
+    if (suite.selected("generation_evaluate_reproduce")) {
+        params.populationSize = 300;
+
+        // lineage kept as in a run (without LOD output)
+        nAncestry ancestry;
+        std::vector<nPopulation*> generations;
+        generations.push_back(new nPopulation);
+        generations.back()->setAncestry(ancestry);
+        generations.back()->populate();
+
+        suite.measure("generation_evaluate_reproduce_300", boost::bind(&oneGeneration, &generations, &game), 3);
+
+        // the same, the children made on a pool of four workers (the same children as above)
+        nScheduler scheduler(4);
+        nRunContext context(seed, &scheduler);
+        nRunContext::scope inContext(context);
+        nAncestry pooledAncestry;
+        std::vector<nPopulation*> pooledGenerations;
+        pooledGenerations.push_back(new nPopulation);
+        pooledGenerations.back()->setAncestry(pooledAncestry);
+        pooledGenerations.back()->populate();
+
+        suite.measure("generation_evaluate_reproduce_300_threads4", boost::bind(&oneGeneration, &pooledGenerations, &game), 3);
+    }
+
+    //// analysis
+    if (suite.selected("mutual_info")) {
+        nAnalyzer analyzer(agent.m_id, agent.m_genome, 0, nullStream);
+        analyzer.m_agent.m_stateHistory.reserve(400000);
+        for (unsigned int i = 0; i < 400000; i++) {
+            analyzer.m_agent.m_prevState = analyzer.m_agent.m_curState;
+            analyzer.m_agent.m_curState = genRandInt() & 0x3f;
+            analyzer.m_agent.updateBrain();
+        }
+        suite.measure("mutual_info_400k", boost::bind(&mutualInfo, &analyzer), 3);
+    }
+
+    size_t nodeCounts[] = {8, 10, 12};
+    for (size_t i = 0; i < 3; i++) {
+        std::ostringstream mipName, mcName;
+        mipName << "MIPs_" << nodeCounts[i] << "_nodes";
+        mcName << "mainComplexes_" << nodeCounts[i] << "_nodes";
+
+        if (!suite.selected(mipName.str()) && !suite.selected(mcName.str()))
+            continue;
+
+        ModularityToolset toolset;
+        MT_ENTROPIES entropies = toolset.entropies(randomTransitionTable(nodeCounts[i], seed));
+
+        suite.measure(mipName.str(), boost::bind(&minimumInformationPartitions, &toolset, &entropies));
+        suite.measure(mcName.str(), boost::bind(&mainComplexes, &toolset, &entropies, nodeCounts[i]));
+    }
+
+    if (suite.selected("approximateMIP_32_nodes")) {
+        MT_TRANSITION_TABLE table = sampledTransitionTable(32, 1UL << 14, seed);
+        suite.measure("approximateMIP_32_nodes", boost::bind(&approximateMIP, &table), 1);
+    }
+
+    // results
+    if (vm.count("output")) {
+        std::ofstream fout(outputFile.c_str());
+        suite.print(fout);
+    }
+    else
+        suite.print(std::cout);
+
+    return 0;
+}
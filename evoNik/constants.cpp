@@ -0,0 +1,269 @@
+//
+//  constants.cpp
+//  evoNik
+//
+
+#include "constants.hpp"
+
+namespace po = boost::program_options;
+
+nParameters params;
+
+// mutations, deletions and insertions per genome by default (the rates are per site)
+static const double genomeMutations = 0.5, genomeDeletions = 0.05, genomeInsertions = 0.05;
+
+
+nParameters::nParameters(){
+
+    //// Population parameters
+    populationSize = 300;
+    elitism = true;
+    purgeFraction = 0.0;
+    selectionMethod = "roulette";
+    tournamentSize = 2;
+    steadyState = false;
+
+    //// Brain network parameters
+    maxNodes = 12;
+
+    //// Genetics factors
+    genomeLength = 100;
+    maxNumHMMs = 10;
+    crossOverOn = false;
+    mutationRate = genomeMutations / genomeLength;
+    deletionRate = genomeDeletions / genomeLength;
+    insertionRate = genomeInsertions / genomeLength;
+
+    //// HMM unit parameters
+    deterministicHMM = true;
+    HMMFanIn = 4;
+    HMMFanOut = 4;
+
+    //// Game parameters
+    maxGenerations = 10000;
+    selectionPressureUpToGeneration = 100.0;
+    selectionPressureFromGeneration = 0.0;
+    evaluationTime = 200;
+    evaluationRepetition = 15;
+    useGeometricMean = false;
+    gravityPresent = false;
+    huntForFood = false;
+    agentDeficit = 0.1;
+    mazeChunkSize = 64;
+    mazeChunkCache = 16;
+
+    //// Island model
+    islands = 1;
+    migrationInterval = 50;
+    migrationRate = 0.02;
+    migrationTopology = "ring";
+
+    //// Phi, etc analysis
+    analysisInterval = 200;
+    useBrainScan = false;
+    useTransitionMatrix = false;
+    includeEnvUpdate = true;
+    calculateOverTimeDelays = 0;
+    pruneNodes = true;
+    approximatePhiAbove = 14;
+    phiSearchBudget = 2000;
+    cacheAnalyses = true;
+
+    //// Output messages
+    suppressMessages = false;
+    lodKeyframeInterval = 100;
+}
+
+
+po::options_description nParameters::options(){
+
+    po::options_description population("Population parameters");
+    population.add_options()
+    ("populationSize", po::value<unsigned int>(&populationSize)->default_value(populationSize), "size")
+    ("elitism", po::value<bool>(&elitism)->default_value(elitism), "the best candidate carryover")
+    ("purgeFraction", po::value<double>(&purgeFraction)->default_value(purgeFraction), "fraction of max. fitness needed to be selected (roulette)")
+    ("selectionMethod", po::value<std::string>(&selectionMethod)->default_value(selectionMethod), "parent selection: roulette, tournament or rank")
+    ("tournamentSize", po::value<unsigned int>(&tournamentSize)->default_value(tournamentSize), "agents per tournament")
+    ("steadyState", po::value<bool>(&steadyState)->default_value(steadyState), "steady state: newborns replace the least fit as they are evaluated");
+
+    po::options_description genetics("Brain and genetics parameters");
+    genetics.add_options()
+    ("maxNodes", po::value<unsigned int>(&maxNodes)->default_value(maxNodes), "number of brain nodes")
+    ("genomeLength", po::value<unsigned int>(&genomeLength)->default_value(genomeLength), "initial genome length")
+    ("maxNumHMMs", po::value<unsigned int>(&maxNumHMMs)->default_value(maxNumHMMs), "maximum number of chromosomes (random genome)")
+    ("crossOverOn", po::value<bool>(&crossOverOn)->default_value(crossOverOn), "allow cross-over")
+    ("mutationRate", po::value<double>(&mutationRate)->default_value(mutationRate), "point mutation rate (per site, default 0.5 / genomeLength)")
+    ("deletionRate", po::value<double>(&deletionRate)->default_value(deletionRate), "deletion rate (per site, default 0.05 / genomeLength)")
+    ("insertionRate", po::value<double>(&insertionRate)->default_value(insertionRate), "insertion rate (per site, default 0.05 / genomeLength)")
+    ("deterministicHMM", po::value<bool>(&deterministicHMM)->default_value(deterministicHMM), "deterministic or stochastic HMM units")
+    ("HMMFanIn", po::value<unsigned int>(&HMMFanIn)->default_value(HMMFanIn), "max. HMM inputs (a power of 2)")
+    ("HMMFanOut", po::value<unsigned int>(&HMMFanOut)->default_value(HMMFanOut), "max. HMM outputs (a power of 2)");
+
+    po::options_description game("Game parameters");
+    game.add_options()
+    ("maxGenerations", po::value<unsigned int>(&maxGenerations)->default_value(maxGenerations), "number of generations in a trial")
+    ("selectionPressureUpToGeneration", po::value<double>(&selectionPressureUpToGeneration)->default_value(selectionPressureUpToGeneration),
+     "selection pressure up to (in percent of total generations)")
+    ("selectionPressureFromGeneration", po::value<double>(&selectionPressureFromGeneration)->default_value(selectionPressureFromGeneration),
+     "selection pressure from (in percent of total generations)")
+    ("evaluationTime", po::value<unsigned int>(&evaluationTime)->default_value(evaluationTime), "fitness evaluation time")
+    ("evaluationRepetition", po::value<unsigned int>(&evaluationRepetition)->default_value(evaluationRepetition), "evaluation repetitions")
+    ("useGeometricMean", po::value<bool>(&useGeometricMean)->default_value(useGeometricMean), "geometric mean of repeated fitnesses")
+    ("gravityPresent", po::value<bool>(&gravityPresent)->default_value(gravityPresent), "does gravity exist")
+    ("huntForFood", po::value<bool>(&huntForFood)->default_value(huntForFood), "is food required")
+    ("agentDeficit", po::value<double>(&agentDeficit)->default_value(agentDeficit), "agent time deficit (fraction) when hunting")
+    ("mazeChunkSize", po::value<unsigned int>(&mazeChunkSize)->default_value(mazeChunkSize), "maze columns generated at a time")
+    ("mazeChunkCache", po::value<unsigned int>(&mazeChunkCache)->default_value(mazeChunkCache), "max. maze chunks held");
+
+    po::options_description islandModel("Island model parameters");
+    islandModel.add_options()
+    ("islands", po::value<unsigned int>(&islands)->default_value(islands), "number of islands (1: a single population)")
+    ("migrationInterval", po::value<unsigned int>(&migrationInterval)->default_value(migrationInterval), "generations between migrations")
+    ("migrationRate", po::value<double>(&migrationRate)->default_value(migrationRate), "fraction of the population migrating over each link")
+    ("migrationTopology", po::value<std::string>(&migrationTopology)->default_value(migrationTopology), "migration topology: ring or full");
+
+    po::options_description analysis("Analysis parameters");
+    analysis.add_options()
+    ("analysisInterval", po::value<unsigned int>(&analysisInterval)->default_value(analysisInterval), "analysis interval (generations)")
+    ("useBrainScan", po::value<bool>(&useBrainScan)->default_value(useBrainScan), "use brain scan instead of maze data")
+    ("useTransitionMatrix", po::value<bool>(&useTransitionMatrix)->default_value(useTransitionMatrix),
+     "use the exact transition probabilities of the brain instead of sampled data")
+    ("includeEnvUpdate", po::value<bool>(&includeEnvUpdate)->default_value(includeEnvUpdate), "analyze including environmental update")
+    ("calculateOverTimeDelays", po::value<unsigned int>(&calculateOverTimeDelays)->default_value(calculateOverTimeDelays), "calculate over timesteps")
+    ("pruneNodes", po::value<bool>(&pruneNodes)->default_value(pruneNodes), "leave disconnected and constant nodes out of Phi")
+    ("approximatePhiAbove", po::value<unsigned int>(&approximatePhiAbove)->default_value(approximatePhiAbove),
+     "approximate Phi of brains with more nodes (by a heuristic MIP search)")
+    ("phiSearchBudget", po::value<unsigned long>(&phiSearchBudget)->default_value(phiSearchBudget),
+     "partitions evaluated by the heuristic MIP search")
+    ("cacheAnalyses", po::value<bool>(&cacheAnalyses)->default_value(cacheAnalyses), "reuse the results of brains analysed before")
+    ("suppressMessages", po::value<bool>(&suppressMessages)->default_value(suppressMessages), "suppress cout messages")
+    ("lodKeyframeInterval", po::value<unsigned int>(&lodKeyframeInterval)->default_value(lodKeyframeInterval),
+     "generations between full genomes in the LOD file (0 or 1: full genomes only)");
+
+    po::options_description all("Experiment parameters");
+    all.add(population).add(genetics).add(game).add(islandModel).add(analysis);
+
+    return all;
+}
+
+
+void nParameters::deriveDefaults(const po::variables_map& vm){
+
+    // the rates not set explicitly follow the genome length
+    if (vm["mutationRate"].defaulted())
+        mutationRate = genomeMutations / genomeLength;
+    if (vm["deletionRate"].defaulted())
+        deletionRate = genomeDeletions / genomeLength;
+    if (vm["insertionRate"].defaulted())
+        insertionRate = genomeInsertions / genomeLength;
+}
+
+
+bool nParameters::isValid(std::ostream& ferr){
+
+    if (maxNodes < 12 || maxNodes > maxNodesLimit) {
+        ferr << "Error in nParameters: maxNodes must be within 12 (sensors and actuators) and "
+        << maxNodesLimit << std::endl;
+        return false;
+    }
+
+    if (HMMFanIn == 0 || (HMMFanIn & (HMMFanIn - 1)) != 0 || HMMFanIn > maxNodes ||
+        HMMFanOut == 0 || (HMMFanOut & (HMMFanOut - 1)) != 0 || HMMFanOut > maxNodes) {
+        ferr << "Error in nParameters: HMMFanIn and HMMFanOut must be powers of 2 (at most maxNodes)" << std::endl;
+        return false;
+    }
+
+    if (selectionMethod != "roulette" && selectionMethod != "tournament" && selectionMethod != "rank") {
+        ferr << "Error in nParameters: unknown selectionMethod " << selectionMethod
+        << " (roulette, tournament or rank)" << std::endl;
+        return false;
+    }
+    
+    if (migrationTopology != "ring" && migrationTopology != "full") {
+        ferr << "Error in nParameters: unknown migrationTopology " << migrationTopology
+        << " (ring or full)" << std::endl;
+        return false;
+    }
+
+    if (islands == 0 || migrationInterval == 0 || migrationRate < 0 || migrationRate > 0.5) {
+        ferr << "Error in nParameters: islands and migrationInterval must be positive, "
+        << "migrationRate within 0 and 0.5" << std::endl;
+        return false;
+    }
+    
+    if (steadyState && islands > 1) {
+        ferr << "Error in nParameters: steadyState does not work with islands" << std::endl;
+        return false;
+    }
+
+    if (approximatePhiAbove > exhaustiveNodesLimit || phiSearchBudget == 0) {
+        ferr << "Error in nParameters: approximatePhiAbove must be at most " << exhaustiveNodesLimit
+        << ", phiSearchBudget positive" << std::endl;
+        return false;
+    }
+
+    if (mazeChunkSize == 0 || mazeChunkCache < 2) {
+        ferr << "Error in nParameters: mazeChunkSize must be positive, mazeChunkCache at least 2" << std::endl;
+        return false;
+    }
+
+    if (populationSize < 2 || tournamentSize < 1 || genomeLength < 10 || maxNumHMMs < 1 || evaluationTime == 0 ||
+        evaluationRepetition == 0 || analysisInterval == 0) {
+        ferr << "Error in nParameters: populationSize, tournamentSize, genomeLength, maxNumHMMs, evaluationTime, "
+        << "evaluationRepetition or analysisInterval too small" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+
+void nParameters::print(std::ostream& fout){
+
+    fout << "# evoNik parameters (usable as --config file)" << std::endl;
+
+    fout << std::boolalpha
+    << "populationSize = " << populationSize << std::endl
+    << "elitism = " << elitism << std::endl
+    << "purgeFraction = " << purgeFraction << std::endl
+    << "selectionMethod = " << selectionMethod << std::endl
+    << "tournamentSize = " << tournamentSize << std::endl
+    << "steadyState = " << steadyState << std::endl
+    << "maxNodes = " << maxNodes << std::endl
+    << "genomeLength = " << genomeLength << std::endl
+    << "maxNumHMMs = " << maxNumHMMs << std::endl
+    << "crossOverOn = " << crossOverOn << std::endl
+    << "mutationRate = " << mutationRate << std::endl
+    << "deletionRate = " << deletionRate << std::endl
+    << "insertionRate = " << insertionRate << std::endl
+    << "deterministicHMM = " << deterministicHMM << std::endl
+    << "HMMFanIn = " << HMMFanIn << std::endl
+    << "HMMFanOut = " << HMMFanOut << std::endl
+    << "maxGenerations = " << maxGenerations << std::endl
+    << "selectionPressureUpToGeneration = " << selectionPressureUpToGeneration << std::endl
+    << "selectionPressureFromGeneration = " << selectionPressureFromGeneration << std::endl
+    << "evaluationTime = " << evaluationTime << std::endl
+    << "evaluationRepetition = " << evaluationRepetition << std::endl
+    << "useGeometricMean = " << useGeometricMean << std::endl
+    << "gravityPresent = " << gravityPresent << std::endl
+    << "huntForFood = " << huntForFood << std::endl
+    << "agentDeficit = " << agentDeficit << std::endl
+    << "mazeChunkSize = " << mazeChunkSize << std::endl
+    << "mazeChunkCache = " << mazeChunkCache << std::endl
+    << "islands = " << islands << std::endl
+    << "migrationInterval = " << migrationInterval << std::endl
+    << "migrationRate = " << migrationRate << std::endl
+    << "migrationTopology = " << migrationTopology << std::endl
+    << "analysisInterval = " << analysisInterval << std::endl
+    << "useBrainScan = " << useBrainScan << std::endl
+    << "useTransitionMatrix = " << useTransitionMatrix << std::endl
+    << "includeEnvUpdate = " << includeEnvUpdate << std::endl
+    << "calculateOverTimeDelays = " << calculateOverTimeDelays << std::endl
+    << "pruneNodes = " << pruneNodes << std::endl
+    << "approximatePhiAbove = " << approximatePhiAbove << std::endl
+    << "phiSearchBudget = " << phiSearchBudget << std::endl
+    << "cacheAnalyses = " << cacheAnalyses << std::endl
+    << "suppressMessages = " << suppressMessages << std::endl
+    << "lodKeyframeInterval = " << lodKeyframeInterval << std::endl
+    << std::noboolalpha;
+}
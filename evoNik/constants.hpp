@@ -9,33 +9,11 @@
 #ifndef evoNik_constants_h
 #define evoNik_constants_h
 
+#include <iostream>
+#include <string>
+#include <limits>
 
-//// Population parameters
-// size
-const unsigned int populationSize = 300;
-// Elitism (the best candidate carryover)
-const bool elitism = true;
-// purge fraction (for biasing selection towards the fittest guys)
-const double purgeFraction = 0.0;
-
-
-//// Brain network parameters 
-const unsigned int maxNodes = 12;
-
-
-//// Genetics factors 
-// genome length
-const unsigned int genomeLength = 100;
-// maximum number of chromosomes
-const unsigned int maxNumHMMs = 10;
-// if crossOver should be allowed
-const bool crossOverOn = false;
-// mutation rate
-const double mutationRate = 0.5 / genomeLength;
-// deletion rate
-const double deletionRate = 0.05 / genomeLength;
-// insertion rate
-const double insertionRate = 0.05 / genomeLength;
+#include <boost/program_options.hpp>
 
 
 //// Genome properties
@@ -45,49 +23,151 @@ const unsigned int startCode1 = 42;
 const unsigned int startCode2 = 255 - 42;
 
 
-//// HMM unit parameters
-// deterministic or stochastic
-const bool deterministicHMM = true;
-// max input size
-const unsigned int HMMFanIn = 4;               // be some power of 2 (i.e. 2^n)
-// max output size
-const unsigned int HMMFanOut = 4;              // be some power of 2 (i.e. 2^n)
-
-//// Game parameters
-// number of generations in a trial
-const unsigned int maxGenerations = 10000;
-// selection pressure up to (in percent of total generations)
-const double selectionPressureUpToGeneration = 100.0;
-// selectionPressure from (in percent of total generations)
-const double selectionPressureFromGeneration = 0.0;
-// fitness evaluation time
-const unsigned int evaluationTime = 200;
-// evaluation repetitions
-const unsigned int evaluationRepetition = 15;
-// use of geometric mean
-const bool useGeometricMean = false;
-// does gravity exist
-const bool gravityPresent = false;
-// is food required
-const bool huntForFood = false;
-// agent time deficit (in percent)
-const double agentDeficit = 0.1;
-
-
-
-//// Phi, etc analysis
-// analysis interval
-const unsigned int analysisInterval = 200;
-// use brain scan instead of maze data
-const bool useBrainScan = false;
-// analyze including environmental update
-const bool includeEnvUpdate = true;
-// calculate over timesteps
-const unsigned int calculateOverTimeDelays = 0;
-
-
-//// Output messages
-// cout messages/information
-const bool suppressMessages = false;
+//// Brain kernel limits
+// a brain state is one word up to this many nodes, a fixed number of them
+// beyond (see nBrainState/nAgent::updateBrain)
+const unsigned int stateWordBits = std::numeric_limits<unsigned long>::digits;
+const unsigned int maxStateWords = 4;
+const unsigned int maxNodesLimit = maxStateWords*stateWordBits;
+// brains up to this size are scanned over all their states and analysed
+// for Phi (2^maxNodes subsets); wider ones are scanned by sampling states
+const unsigned int exhaustiveNodesLimit = 16;
+// exact transition matrices (see nTransitionMatrix) with more transitions than
+// this are not analysed (stochastic brains spread over most states quickly)
+const unsigned long exactTransitionsLimit = 1UL << 16;
+
+
+//// Run-time parameters
+// every experiment knob, set from a configuration file and/or
+// the command line (defaults in constants.cpp)
+class nParameters{
+public:
+
+    //// Population parameters
+    // size
+    unsigned int populationSize;
+    // Elitism (the best candidate carryover)
+    bool elitism;
+    // purge fraction (for biasing selection towards the fittest guys)
+    double purgeFraction;
+    // parent selection: roulette, tournament or rank (see nSelection)
+    std::string selectionMethod;
+    // agents per tournament (tournament selection)
+    unsigned int tournamentSize;
+    // steady state: no generations, every newborn replaces the least fit member as soon as
+    // it is evaluated (a generation is populationSize births, see nSteadyState)
+    bool steadyState;
+
+
+    //// Brain network parameters
+    unsigned int maxNodes;
+
+
+    //// Genetics factors
+    // genome length
+    unsigned int genomeLength;
+    // maximum number of chromosomes
+    unsigned int maxNumHMMs;
+    // if crossOver should be allowed
+    bool crossOverOn;
+    // mutation rate (per site)
+    double mutationRate;
+    // deletion rate (per site)
+    double deletionRate;
+    // insertion rate (per site)
+    double insertionRate;
+
+
+    //// HMM unit parameters
+    // deterministic or stochastic
+    bool deterministicHMM;
+    // max input size
+    unsigned int HMMFanIn;               // be some power of 2 (i.e. 2^n)
+    // max output size
+    unsigned int HMMFanOut;              // be some power of 2 (i.e. 2^n)
+
+
+    //// Game parameters
+    // number of generations in a trial
+    unsigned int maxGenerations;
+    // selection pressure up to (in percent of total generations)
+    double selectionPressureUpToGeneration;
+    // selectionPressure from (in percent of total generations)
+    double selectionPressureFromGeneration;
+    // fitness evaluation time
+    unsigned int evaluationTime;
+    // evaluation repetitions
+    unsigned int evaluationRepetition;
+    // use of geometric mean
+    bool useGeometricMean;
+    // does gravity exist
+    bool gravityPresent;
+    // is food required
+    bool huntForFood;
+    // agent time deficit (in percent)
+    double agentDeficit;
+    // maze columns generated at a time
+    unsigned int mazeChunkSize;
+    // max. maze chunks held (least recently used ones are dropped)
+    unsigned int mazeChunkCache;
+
+
+    //// Island model
+    // number of islands (populations evolving side by side, 1: a single population)
+    unsigned int islands;
+    // generations between migrations
+    unsigned int migrationInterval;
+    // fraction of the population migrating over each link (at least one agent)
+    double migrationRate;
+    // who receives from whom: ring or full (see nArchipelago)
+    std::string migrationTopology;
+
+
+    //// Phi, etc analysis
+    // analysis interval
+    unsigned int analysisInterval;
+    // use brain scan instead of maze data
+    bool useBrainScan;
+    // use the exact transition probabilities of the brain instead (up to exhaustiveNodesLimit nodes, exactTransitionsLimit transitions)
+    bool useTransitionMatrix;
+    // analyze including environmental update
+    bool includeEnvUpdate;
+    // calculate over timesteps
+    unsigned int calculateOverTimeDelays;
+    // leave nodes wired to no unit or constant over the data out of Phi and the main complex
+    bool pruneNodes;
+    // brains with more nodes than this (that can be integrated, at most exhaustiveNodesLimit) are
+    // not run over all their subsets and partitions: Phi is that of the MIP of all of them found
+    // by a heuristic search (see PartitionSearch.h)
+    unsigned int approximatePhiAbove;
+    // partitions evaluated by the heuristic MIP search
+    unsigned long phiSearchBudget;
+    // reuse the results of brains analysed before (kept in the run directory, see nAnalysisCache)
+    bool cacheAnalyses;
+
+
+    //// Output messages
+    // cout messages/information
+    bool suppressMessages;
+    // generations between full genomes in the LOD file (edits against the previous entry in between, 0 or 1: full genomes only)
+    unsigned int lodKeyframeInterval;
+
+
+    // constructor (default values)
+    nParameters();
+
+    // member functions
+    // program options for all the parameters (to parse a config file or command line)
+    boost::program_options::options_description options(void);
+    // once the options are parsed: the defaults that depend on other parameters
+    void deriveDefaults(const boost::program_options::variables_map& vm);
+    // check consistency (false, with a message, if unusable)
+    bool isValid(std::ostream& ferr = std::cerr);
+    // write out (in config file format)
+    void print(std::ostream& fout = std::cout);
+};
+
+// the parameters of this process (set up once, before any run starts)
+extern nParameters params;
 
 #endif
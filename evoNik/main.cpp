@@ -8,22 +8,126 @@
 
 #include "utility.hpp"
 #include "nRun.hpp"
+#include "nArchipelago.hpp"
 #include "nAnalyzer.hpp"
+#include "nLOD.hpp"
 
 int main (int argc, char* argv[]){
     
-    if (argc < 3) {
-        std::cerr << "Error in main: Specify experiment name and run number" << std::endl;
-        std::cerr << "usage ./evoNik [EXP_NAME_STRING] [RUN_INDEX]" <<std::endl;
+    std::string runName, configFile, lodFile, runDirectory;
+    unsigned int runIndex, replicates, numThreads, seed, generation;
+    
+    // run options
+    po::options_description runOptions("Run options");
+    runOptions.add_options()
+    ("help,h", "print this message")
+    ("name", po::value<std::string>(&runName), "experiment name")
+    ("run", po::value<unsigned int>(&runIndex)->default_value(0), "run index (of the first replicate)")
+    ("replicates", po::value<unsigned int>(&replicates)->default_value(1), "number of replicates evolved concurrently")
+    ("threads", po::value<unsigned int>(&numThreads), "number of worker threads (default: 1 for a single run, else one per core)")
+    ("seed", po::value<unsigned int>(&seed), "random seed of the first replicate (default: time based)")
+    ("config", po::value<std::string>(&configFile), "configuration file with experiment parameters (overridden by the command line)")
+    ("lod", po::value<std::string>(&lodFile), "print the genome of --generation from a LOD file (lod_output.txt) instead")
+    ("generation", po::value<unsigned int>(&generation)->default_value(0), "generation to print from the LOD file")
+    ("reanalyse", po::value<std::string>(&runDirectory), "analyse the LOD of a run directory again (every --analysisInterval generations, its parameters.txt and analysisCache.txt reused) instead");
+    
+    po::options_description allOptions;
+    allOptions.add(runOptions).add(params.options());
+    
+    // positional: experiment name and run number
+    po::positional_options_description positional;
+    positional.add("name", 1).add("run", 1);
+    
+    po::variables_map vm;
+    try {
+        po::store(po::command_line_parser(argc, argv).options(allOptions).positional(positional).run(), vm);
+        
+        // parameters from the configuration file (the command line has precedence)
+        if (vm.count("config")) {
+            std::ifstream config(vm["config"].as<std::string>().c_str());
+            if (!config.is_open()) {
+                std::cerr << "Error in main: can not open configuration file "
+                << vm["config"].as<std::string>() << std::endl;
+                exit(1);
+            }
+            po::store(po::parse_config_file(config, allOptions), vm);
+        }
+        
+        // the parameters of the run to be reanalysed (overridden by the command line and the configuration file)
+        if (vm.count("reanalyse")) {
+            std::string parameterFile = vm["reanalyse"].as<std::string>() + "/parameters.txt";
+            std::ifstream runParameters(parameterFile.c_str());
+            if (!runParameters.is_open()) {
+                std::cerr << "Error in main: can not open " << parameterFile << std::endl;
+                exit(1);
+            }
+            po::store(po::parse_config_file(runParameters, allOptions), vm);
+        }
+        
+        po::notify(vm);
+        params.deriveDefaults(vm);
+    } catch (po::error& e) {
+        std::cerr << "Error in main: " << e.what() << std::endl;
+        exit(1);
+    }
+    
+    // rebuild a genome of a line of descent
+    if (vm.count("lod") && !vm.count("help")) {
+        std::ifstream lod(lodFile.c_str());
+        if (!lod.is_open()) {
+            std::cerr << "Error in main: can not open LOD file " << lodFile << std::endl;
+            exit(1);
+        }
+        nGenome genome;
+        if (!nLOD::readGeneration(lod, generation, genome)) {
+            std::cerr << "Error in main: no generation " << generation << " in " << lodFile << std::endl;
+            exit(1);
+        }
+        std::cout << "# Gen no. " << generation << std::endl;
+        genome.printGenome(std::cout);
+        return 0;
+    }
+    
+    // analyse an earlier run again
+    if (vm.count("reanalyse") && !vm.count("help")) {
+        if (!params.isValid())
+            exit(1);
+        init();
+        nRun::reanalyse(runDirectory, vm.count("threads") ? numThreads : 1);
+        return 0;
+    }
+    
+    if (vm.count("help") || !vm.count("name")) {
+        if (!vm.count("help"))
+            std::cerr << "Error in main: Specify experiment name and run number" << std::endl;
+        std::cerr << "usage ./evoNik [EXP_NAME_STRING] [RUN_INDEX] [OPTIONS]" <<std::endl;
         std::cerr << "e.g. ./evoNik test 0" << std::endl;
+        std::cerr << "     ./evoNik test 0 --replicates 8 --threads 4 --config exp.cfg --maxGenerations 2000" << std::endl;
+        std::cerr << "     ./evoNik --lod lod_output.txt --generation 1500" << std::endl;
+        std::cerr << "     ./evoNik --reanalyse test_2012_Apr_20/Run_0_10_00_00 --analysisInterval 10" << std::endl;
+        std::cerr << allOptions << std::endl;
         exit(0);
     }
     
+    if (!params.isValid())
+        exit(1);
+    
     init();
     
-    nRun testRun(argv[1], atoi(argv[2]));
-    testRun.go();
-    testRun.close();
+    replicates = std::max(1u, replicates);
+    if (params.islands > 1 && replicates > 1) {
+        std::cerr << "Error in main: islands evolve one replicate at a time" << std::endl;
+        exit(1);
+    }
+    if (!vm.count("threads"))
+        numThreads = (replicates > 1) ? 0 : 1;
+    if (!vm.count("seed"))
+        seed = genRandInt();
+    
+    if (params.islands > 1)
+        nArchipelago::goIslands(runName, runIndex, seed, vm.count("threads") ? numThreads : 0);
+    else
+        nRun::goReplicates(runName, runIndex, replicates, seed, numThreads);
     
     return 0;
 }
@@ -11,9 +11,7 @@
 
 #include "nAgent.hpp"
 #include "nAnalyzer.hpp"
-
-unsigned int nAgent::masterID=0;
-
+#include "nLOD.hpp"
 
 
 void nAgent::initialize(){
@@ -21,22 +19,17 @@ void nAgent::initialize(){
     m_position.x = m_position.y = 0;
     m_prevPosition.x = m_prevPosition.y = 0;
     m_curState = m_prevState = 0;
+    m_curHighState = m_prevHighState = highState();
     m_stateHistory.clear();
+    m_wideStateHistory.clear();
     m_maskedNode = -1;
     m_maskValue = 0;
     m_fitness = 0;
     m_fitnessEvalCount = 0;
-    m_lineageSize = 0;
-    
-    // if genome present build HMM units
-    if (!m_genome.m_genome.empty())
-        this->buildHMMs();
-    
-    // add to lineage
-    if (!m_addedToLineage){
-        updateLineage(+1);
-        m_addedToLineage = true;
-    }
+    m_generation = 0;
+    m_ancestryRow = 0;
+    m_origin.island = -1;
+    m_origin.id = m_origin.generation = 0;
 }
 
 bool nAgent::isValid(){
@@ -63,10 +56,10 @@ void nAgent::setupRandomGenome(unsigned int nucleotides){
     
     // fill in nucleotides
     for(size_t i = 0; i < nucleotides; i++)
-        m_genome.setGene(rand()&(long)(pow(2, maxNodes)-1), (int)i); 
+        m_genome.setGene(genRandInt()&((params.maxNodes < 32) ? (1u << params.maxNodes) - 1 : ~0u), (int)i); 
     
     // implant start codons 
-    unsigned int numberOfHMMs = (unsigned int)genUniRand(1, maxNumHMMs);
+    unsigned int numberOfHMMs = (unsigned int)genUniRand(1, params.maxNumHMMs);
     for (unsigned int i = 0; i < numberOfHMMs; i++) {
         // select a random position along the genome
         unsigned int j = (unsigned int)genUniRand(0, m_genome.getSize() - 5);
@@ -83,15 +76,39 @@ void nAgent::setupRandomGenome(unsigned int nucleotides){
 void nAgent::buildHMMs(){
     // clear previour record, if any
     m_hmms.clear();
+    m_deterministicUnits.clear();
+    m_stochasticUnits.clear();
+    m_wideDeterministicUnits.clear();
+    m_wideStochasticUnits.clear();
     
     // run through the whole genome
     for (unsigned int i = 0; i < m_genome.getSize(); i++) {
         // check for a start-codon
         if (m_genome.getGene(i) == startCode1 &&
             m_genome.getGene(i+1) == startCode2) {
-            m_hmms.push_back(nHMMUnit(m_genome,i));
+            m_hmms.emplace_back(m_genome, i);
         }
     }
+    
+    // compile the units for the brain engine in use (on wide states for a wide brain)
+    if (wideBrain()) {
+        if (params.deterministicHMM)
+            m_wideDeterministicUnits.assign(m_hmms.begin(), m_hmms.end());
+        else
+            m_wideStochasticUnits.assign(m_hmms.begin(), m_hmms.end());
+        return;
+    }
+    
+    if (params.deterministicHMM)
+        m_deterministicUnits.reserve(m_hmms.size());
+    else
+        m_stochasticUnits.reserve(m_hmms.size());
+    for (std::vector<nHMMUnit>::iterator it = m_hmms.begin(); it != m_hmms.end(); it++) {
+        if (params.deterministicHMM)
+            m_deterministicUnits.push_back(nHMMKernel<true>(*it));
+        else
+            m_stochasticUnits.push_back(nHMMKernel<false>(*it));
+    }
 }
 
 
@@ -154,37 +171,9 @@ void nAgent::loadGenomeFromFile(std::fstream& genFile, unsigned int id){
     // clear the genome first
     m_genome.m_genome.clear();
     
-    std::string line;
-    
-    // the correct genome
-    bool genomeOfInterest = false;
+    // (a genome file or a LOD file, with entries in edits between keyframes)
+    nLOD::readAgent(genFile, id, m_genome);
     
-    while (getline(genFile, line)) {
-        
-        // trim the line for any spaces and carries
-        boost::trim_if(line, boost::is_any_of(" \t"));
-        
-        // split into separate strings
-        std::vector<std::string> geneString;
-        boost::split(geneString, line, boost::is_any_of("\t "));
-        
-        if (geneString.size() != 0){
-            // if it is a comment
-            if (geneString[0] == "#"){
-                // if the last word is the given id
-                if((unsigned int)std::atoi(geneString[geneString.size()-1].c_str()) == id)
-                    genomeOfInterest = true;
-            }
-            else if (genomeOfInterest){            
-                for (std::vector<std::string>::iterator it = geneString.begin();
-                     it != geneString.end(); it++)
-                    m_genome.m_genome.push_back((unsigned int)std::atoi(it->c_str()));
-                
-                genomeOfInterest = false;
-            }
-        }
-    }
-
     // update HMM units
     buildHMMs();
 }
@@ -219,9 +208,6 @@ void nAgent::mutate(double rate){
     for(size_t i = 0; i < numGenes; i++)
         if (genUniRand(0, 1) < rate) 
             m_genome.setGene((unsigned int) floor(genUniRand(0, 255)), (int)i);
-    
-    // update HMMs
-    buildHMMs();
 }
 
 
@@ -230,9 +216,6 @@ void nAgent::applyDeletion(double rate){
     for(size_t i = 0; i < numGenes; i++)
         if (genUniRand(0, 1) < rate) 
             m_genome.deleteGene((int)i);
-    
-    // update HMMs 
-    buildHMMs();
 }
 
 void nAgent::applyInsertion(double rate){
@@ -240,21 +223,33 @@ void nAgent::applyInsertion(double rate){
     for(size_t i = 0; i < numGenes; i++)
         if (genUniRand(0, 1) < rate) 
             m_genome.insertGene((unsigned int) floor(genUniRand(0, 255)), (int)i);
-    
-    // update HMMs
-    buildHMMs();
+}
+
+
+// room left in a child genome for the insertions to come (four times as many as
+// expected, so that it is allocated once)
+static size_t insertionRoom(size_t genes){
+    return 2 + (size_t)(4 * params.insertionRate * genes);
 }
 
 
 std::pair<nAgent, nAgent> nAgent::crossOver(nAgent &partner){
+    return crossOver(partner, nRunContext::current().nextAgentIDs(2));
+}
+
+
+std::pair<nAgent, nAgent> nAgent::crossOver(nAgent &partner, unsigned int firstID){
     // select a cross over point
     unsigned int crossOverLocation = (int)floor(genUniRand(1, m_genome.getSize()));
         
-    // a new baby is borned
-    std::pair<nAgent, nAgent> children = std::make_pair(nAgent(*this, partner), 
-                                                               nAgent(*this, partner));
+    // two babies are borned
+    std::pair<nAgent, nAgent> children{nAgent(firstID), nAgent(firstID + 1)};
+    children.first.setParents(*this, partner);
+    children.second.setParents(*this, partner);
     
     // form the genome of the baby by crossing over with the partner
+    children.first.m_genome.m_genome.reserve(this->m_genome.getSize() + insertionRoom(this->m_genome.getSize()));
+    children.second.m_genome.m_genome.reserve(partner.m_genome.getSize() + insertionRoom(partner.m_genome.getSize()));
     children.first.m_genome.setSize(this->m_genome.getSize());
     children.second.m_genome.setSize(partner.m_genome.getSize());
     
@@ -272,58 +267,152 @@ std::pair<nAgent, nAgent> nAgent::crossOver(nAgent &partner){
     // further cross-over? (with probability 0.01)
     // TBD
     
-    // build HMM units
-    children.first.buildHMMs();
-    children.second.buildHMMs();
-                                                        
+    // (HMM units are built once the children are varied further)
     return children;
 }
 
 
 nAgent nAgent::inheriteViaMutation(){
+    return inheriteViaMutation(nRunContext::current().nextAgentID());
+}
+
+
+nAgent nAgent::inheriteViaMutation(unsigned int id){
+    
+    // child is borned with the genome of the parent
+    nAgent child(inheriteGenome(id));
+    
+    // mutate genome (HMM units are built once the child is varied further)
+    child.mutate();
+   
+    return child;
+}
+
+
+nAgent nAgent::inheriteGenome(){
+    return inheriteGenome(nRunContext::current().nextAgentID());
+}
+
+
+nAgent nAgent::inheriteGenome(unsigned int id){
     
     // child is borned
-    nAgent child(*this);
+    nAgent child(id);
+    child.m_parents.push_back(this);
     
     // setup genome from the parent
-    child.m_genome = this->m_genome; 
+    child.m_genome.inherit(this->m_genome, insertionRoom(this->m_genome.getSize()));
     
-    // mutate genome
-    child.mutate();
-   
-    // build HMM units
-    child.buildHMMs();
-   
     return child;
 }
 
+
+nAgent nAgent::inheriteAsClone(){
+    
+    // child is borned
+    nAgent child(*this);
+    
+    // with the exact genome and brain of its mother
+    child.m_genome = this->m_genome;
+    child.m_hmms = this->m_hmms;
+    child.m_deterministicUnits = this->m_deterministicUnits;
+    child.m_stochasticUnits = this->m_stochasticUnits;
+    child.m_wideDeterministicUnits = this->m_wideDeterministicUnits;
+    child.m_wideStochasticUnits = this->m_wideStochasticUnits;
+    
+    return child;
+}
+
+bool nAgent::getPhenotype(std::vector<unsigned long>& phenotype) const{
+    
+    phenotype.clear();
+    
+    // stochastic units are not a function of the brain state
+    if (!isDeterministic())
+        return false;
+    
+    // the units in firing order
+    for (std::vector<nHMMKernel<true> >::const_iterator it = m_deterministicUnits.begin();
+         it != m_deterministicUnits.end(); it++)
+        it->appendPhenotype(phenotype);
+    for (std::vector<nHMMKernel<true, wideState> >::const_iterator it = m_wideDeterministicUnits.begin();
+         it != m_wideDeterministicUnits.end(); it++)
+        it->appendPhenotype(phenotype);
+    
+    return true;
+}
+
+
 void nAgent::updateBrain(){
+    
+    // a wide brain: its whole states (the first words as set by the game)
+    if (wideBrain()) {
+        wideState curState(m_curState, m_curHighState), prevState(m_prevState, m_prevHighState);
+        
+        if (m_wideStochasticUnits.empty())
+            updateBrainKernel(m_wideDeterministicUnits, curState, prevState);
+        else
+            updateBrainKernel(m_wideStochasticUnits, curState, prevState);
+        
+        m_curState = curState.low();
+        m_curHighState = curState.high();
+        m_prevState = prevState.low();
+        m_prevHighState = prevState.high();
+        m_wideStateHistory.push_back(std::make_pair(prevState, curState));
+    }
+    
+    // fire the units compiled at build time of the brain
+    else if (m_stochasticUnits.empty())
+        updateBrainKernel(m_deterministicUnits, m_curState, m_prevState);
+    else
+        updateBrainKernel(m_stochasticUnits, m_curState, m_prevState);
+    
+    // update brain state history (if no inclusion of environmental update)
+   // if (!includeEnvUpdate)
+    m_stateHistory.push_back(std::make_pair(m_prevState, m_curState));
+}
+
+
+template<typename Kernel, typename State>
+void nAgent::updateBrainKernel(const std::vector<Kernel>& units, State& curState, State& prevState) const{
 
     // apply mask, if any
-    applyMask(m_curState, m_maskedNode, m_maskValue);
-    applyMask(m_prevState, m_maskedNode, m_maskValue);
+    applyMask(curState, m_maskedNode, m_maskValue);
+    applyMask(prevState, m_maskedNode, m_maskValue);
  
     // a temp state
-    unsigned long tempState = m_prevState;
+    State tempState = prevState;
     
     // run all HMM units on the current brain state to get the next state
-    for (std::vector<nHMMUnit>::iterator it = m_hmms.begin(); it != m_hmms.end(); it++) {
+    for (typename std::vector<Kernel>::const_iterator it = units.begin(); it != units.end(); it++) {
         // apply the effect of "this" HMM unit
-        it->fire(tempState, m_curState);
+        it->fire(tempState, curState);
         // apply mask, if any
-        applyMask(m_curState, m_maskedNode, m_maskValue);
+        applyMask(curState, m_maskedNode, m_maskValue);
         
         // go for next hmm
-        tempState = m_curState;        
+        tempState = curState;        
     }
-    
-    // update brain state history (if no inclusion of environmental update)
-   // if (!includeEnvUpdate)
-    m_stateHistory.push_back(std::make_pair(m_prevState, m_curState));
 }
 
 
 
+// print state transitions (one word or wide states)
+template<typename State>
+static void printStates(std::ostream& fout, typename std::vector<std::pair<State, State> >::const_iterator first,
+                        typename std::vector<std::pair<State, State> >::const_iterator last, bool saveBinary){
+    for (typename std::vector<std::pair<State, State> >::const_iterator it = first; it != last; it++) {
+        if (saveBinary)
+            fout << "(" << it->first << ")\t" 
+            << toBinary(it->first, params.maxNodes) << "\t"
+            << "(" << it->second << ")\t" 
+            << toBinary(it->second, params.maxNodes) << std::endl;
+        else
+            fout << it->first << "\t" << it->second << std::endl;
+    }
+}
+
+
 void nAgent::printBrainStateHistory(std::ostream& fout, bool saveBinary){
     
     // if state history is empty
@@ -332,17 +421,11 @@ void nAgent::printBrainStateHistory(std::ostream& fout, bool saveBinary){
         << "can not print brain history" << std::endl;
         exit(1);
     }
-        
-    for (std::vector<std::pair<unsigned long, unsigned long> >::iterator it = m_stateHistory.begin();
-         it != m_stateHistory.end(); it++) {
-        if (saveBinary)
-            fout << "(" << it->first << ")\t" 
-            << binary(maxNodes, it->first) << "\t"
-            << "(" << it->second << ")\t" 
-            << binary(maxNodes, it->second) << std::endl;
-        else
-            fout << it->first << "\t" << it->second << std::endl;
-    }
+    
+    if (wideBrain())
+        printStates<wideState>(fout, m_wideStateHistory.begin(), m_wideStateHistory.end(), saveBinary);
+    else
+        printStates<unsigned long>(fout, m_stateHistory.begin(), m_stateHistory.end(), saveBinary);
 }
 
 
@@ -350,19 +433,37 @@ void nAgent::printBrainStateHistory(std::ostream& fout, bool saveBinary){
 std::vector<std::pair<unsigned long, unsigned long> > nAgent::getBrainScan(){
     // note down the current brain state
     unsigned long tempCurBrainState = this->getBrainState();
+    highState tempCurHighState = m_curHighState;
     
     // brain scan
     std::vector<std::pair<unsigned long, unsigned long> > brainScan;
     
     // how many times one input state is to be invoked
-    int invokeRepeats = (deterministicHMM) ? 1 : 10;
+    int invokeRepeats = (params.deterministicHMM) ? 1 : 10;
     
-    // run through each possible input state
-    for (int i = 0; i < (1 << maxNodes); i++) {
+    // every possible input state of a small brain, as many sampled states of a wide one
+    // (a sampled state is drawn word by word, the last one masked to the nodes in it)
+    bool exhaustive = params.maxNodes <= exhaustiveNodesLimit;
+    unsigned long scanSize = 1UL << std::min(params.maxNodes, exhaustiveNodesLimit);
+    unsigned int stateWords = (params.maxNodes + stateWordBits - 1)/stateWordBits;
+    unsigned int lastWordNodes = params.maxNodes - (stateWords - 1)*stateWordBits;
+    unsigned long lastWordMask = (lastWordNodes < stateWordBits) ? (1UL << lastWordNodes) - 1 : ~0UL;
+    
+    for (unsigned long i = 0; i < scanSize; i++) {
+        
+        wideState inputState(i);
+        if (!exhaustive)
+            for (unsigned int w = 0; w < stateWords; w++) {
+                unsigned long word = genRandInt();
+                word = (word << 32) | genRandInt();
+                inputState.word(w) = (w + 1 < stateWords) ? word : word & lastWordMask;
+            }
+        
         // repeat it for 50 times
         for (int j = 0; j < invokeRepeats; j++) {
 
-            m_prevState = m_curState = (unsigned long)i;
+            m_prevState = m_curState = inputState.low();
+            m_prevHighState = m_curHighState = inputState.high();
             this->updateBrain();
             brainScan.push_back(std::make_pair(m_prevState, m_curState));
         }
@@ -370,6 +471,7 @@ std::vector<std::pair<unsigned long, unsigned long> > nAgent::getBrainScan(){
     
     // restore the present brain state
     m_curState = tempCurBrainState;
+    m_curHighState = tempCurHighState;
     
     return brainScan;
 
@@ -377,12 +479,25 @@ std::vector<std::pair<unsigned long, unsigned long> > nAgent::getBrainScan(){
 
 
 void nAgent::printBrainScan(std::ostream& fout, bool saveBinary){
+    size_t scanned = m_wideStateHistory.size();
     std::vector<std::pair<unsigned long, unsigned long> > bScan = this->getBrainScan();
     
+    // (the whole states of a wide brain, as they were added to its history)
+    if (wideBrain()) {
+        for (std::vector<std::pair<wideState, wideState> >::iterator it = m_wideStateHistory.begin() + scanned;
+             it != m_wideStateHistory.end(); it++) {
+            if (saveBinary)
+                fout << toBinary(it->first, params.maxNodes) << "\t" << toBinary(it->second, params.maxNodes) << std::endl;
+            else
+                fout << it->first << "\t" << it->second << std::endl;
+        }
+        return;
+    }
+    
     for (std::vector<std::pair<unsigned long, unsigned long> >::iterator it = bScan.begin();
          it != bScan.end(); it++) {
         if (saveBinary)
-            fout << binary(maxNodes, it->first) << "\t" << binary(maxNodes, it->second) << std::endl;
+            fout << binary(params.maxNodes, it->first) << "\t" << binary(params.maxNodes, it->second) << std::endl;
         else
             fout << it->first << "\t" << it->second << std::endl;
     }
@@ -422,57 +537,9 @@ double nAgent::costOfComputation() const{
     nAnalyzer ana1(m_id, m_genome, m_fitness, ipred);
     ana1.setRequirements("ipred");
     ana1.m_agent.m_stateHistory = m_stateHistory;
+    ana1.m_agent.m_wideStateHistory = m_wideStateHistory;
     
-    return std::atof(ipred.str().c_str())/maxNodes;
-}
-
-
-void nAgent::updateLineage(int changeFactor, std::vector<unsigned int> accountedAncestors){
-
-    // update record for each parent
-    if (m_parents.size() != 0) {
-        if (m_id == 0)
-            std::cout << "id = " << m_id << " and parent size = " << m_parents.size() << std::endl; 
-        for (std::vector<nAgent*>::iterator it = m_parents.begin(); 
-             it != m_parents.end(); it++) {
-            
-            // check if this was already accounted
-            bool accounted = false;
-            for (std::vector<unsigned int>::iterator it1 = accountedAncestors.begin();
-                 it1 != accountedAncestors.end(); it1++) {
-                if ((*it)->m_id == *it1) {
-                    accounted = true;
-                }
-            }
-            
-            // if not accounted already proceed
-            if (!accounted) {
-                // first make it accounted
-                accountedAncestors.push_back((*it)->m_id);
-                // increment the parentlineageSize
-                (*it)->m_lineageSize += changeFactor;
-                // propagate down the lineage
-                (*it)->updateLineage(changeFactor, accountedAncestors);
-            }
-        }
-    }    
-}
-
-
-void nAgent::removeFromLineage(){
-    if (m_lineageSize != 0){
-        std::cerr << "Error in nAgent: can not remove agent # "
-        << m_id << "... it has non-zero lineage!"
-        << std::endl;
-    }    
-    else if (m_alive){
-        std::cerr << "Error in nAgent: can not remove agent # "
-        << m_id << " ... it is still alive!"
-        << std::endl;
-    }
-    else {
-        updateLineage(-1);
-    }
+    return std::atof(ipred.str().c_str())/params.maxNodes;
 }
 
 
@@ -491,6 +558,14 @@ void nAgent::analyze(bool useBrainScan, std::ostream* fout){
         std::cerr << "I will use brainScan for analysis!" << std::endl;
         getBrainScan();
     }
+    
+    // Phi runs over all subsets of the nodes: not for wide brains
+    if (params.maxNodes > exhaustiveNodesLimit) {
+        *fout << m_id << "\t" << m_fitness << "\t" << "\t" << "nan" << "\t\t" << std::endl;
+        if (useBrainScan)
+            m_stateHistory = origStateHistory;
+        return;
+    }
         
     // initialize modularity toolset
     ModularityToolset toolset;
@@ -501,8 +576,8 @@ void nAgent::analyze(bool useBrainScan, std::ostream* fout){
     for (std::vector<std::pair<unsigned long, unsigned long> >::iterator it = m_stateHistory.begin();
          it != m_stateHistory.end(); it++){
         
-        MT_STATE x0state = MT_STATE(maxNodes, it->first);
-        transTable[x0state.to_ulong()].push_back(MT_STATE(maxNodes, it->second));
+        MT_STATE x0state = MT_STATE(params.maxNodes, it->first);
+        transTable[x0state.to_ulong()].push_back(MT_STATE(params.maxNodes, it->second));
     }    
     
     // entropy calculations
@@ -515,7 +590,7 @@ void nAgent::analyze(bool useBrainScan, std::ostream* fout){
     //double Phi = toolset.ei(MIP[0], ENM_NONE, entropies);
         
     // main complex
-    std::pair<std::vector<std::vector<size_t> >,double> mainComplexes = toolset.mainComplexes(totalPartition(maxNodes),
+    std::pair<std::vector<std::vector<size_t> >,double> mainComplexes = toolset.mainComplexes(totalPartition(params.maxNodes),
                                                                                               entropies,
                                                                                               ENM_TONONI_BALDUZZI);    
     
@@ -13,8 +13,11 @@
 #include <cmath>
 
 #include "utility.hpp"
+#include "nRunContext.hpp"
 #include "nGenome.hpp"
 #include "nHMMUnit.hpp"
+#include "nHMMKernel.hpp"
+#include "nBrainState.hpp"
 #include "ModularityToolset/ModularityToolset.h"
 
 // for computational costs
@@ -23,9 +26,6 @@ class nAnalyzer;
 
 class nAgent {
 public:
-    // master agent identification number
-    static unsigned int masterID;
-    
     /* evolution */
     // id of the agent
     unsigned int m_id;
@@ -35,22 +35,38 @@ public:
     nGenome m_genome;
     // corresponding HMM units
     std::vector<nHMMUnit> m_hmms;    
+    // the HMM units compiled for firing (one of the two, see buildHMMs)
+    std::vector<nHMMKernel<true> > m_deterministicUnits;
+    std::vector<nHMMKernel<false> > m_stochasticUnits;
+    // the same, for a brain wider than a state word (see wideBrain)
+    std::vector<nHMMKernel<true, wideState> > m_wideDeterministicUnits;
+    std::vector<nHMMKernel<false, wideState> > m_wideStochasticUnits;
     // alive or dead
     bool m_alive;
     // fitness
     double m_fitness;
     // fitness evaluation count
     unsigned int m_fitnessEvalCount;
-    // size of lineage following "this" agent
-    unsigned int m_lineageSize;
-    // added to lineage
-    bool m_addedToLineage;
+    // generation born in (set by nAncestry)
+    unsigned int m_generation;
+    // row of the agent in its generation of the ancestry (set by nAncestry)
+    unsigned int m_ancestryRow;
+    // where an immigrant comes from: island, id and generation there (island -1: born here)
+    struct origin{
+        int island;
+        unsigned int id, generation;
+    };
+    origin m_origin;
 
     /* brain */
-    // states
+    // states (the nodes of the first word: sensors and actuators are among them)
     unsigned long m_curState, m_prevState;
-    // history
+    // the rest of the states of a wide brain
+    highState m_curHighState, m_prevHighState;
+    // history (of the first words)
     std::vector<std::pair<unsigned long, unsigned long> > m_stateHistory;
+    // history of the whole states of a wide brain
+    std::vector<std::pair<wideState, wideState> > m_wideStateHistory;
     // masked node (for knockout analysis)
     int m_maskedNode;
     // masked to value
@@ -62,9 +78,8 @@ public:
     std::vector<position> m_trajectory;
     
     // constructor
-    nAgent():m_id(masterID++){
+    nAgent():m_id(nRunContext::current().nextAgentID()){
       //  m_parents.clear();
-        m_addedToLineage = false;
         this->initialize();
     }
     
@@ -72,48 +87,75 @@ public:
     nAgent(unsigned int id)
     : m_id(id){
    //     m_parents.clear();
-        m_addedToLineage = false;
         this->initialize();
     }
     
     // constructor with parents
-    nAgent(std::vector<nAgent*> parents)
-    : m_id(masterID++), m_parents(parents){
-        m_addedToLineage = false;
+    nAgent(const std::vector<nAgent*>& parents)
+    : m_id(nRunContext::current().nextAgentID()), m_parents(parents){
         this->initialize();
     }
     
     // constructor with parents v2
     nAgent(nAgent &parent1, nAgent &parent2)
-    : m_id(masterID++){
+    : m_id(nRunContext::current().nextAgentID()){
         m_parents.push_back(&parent1);
         m_parents.push_back(&parent2);
-        m_addedToLineage = false;
         this->initialize();
     }
     
     // constructor with a single Mother
     nAgent(nAgent& singleMother)
-    : m_id(masterID++){
+    : m_id(nRunContext::current().nextAgentID()){
         m_parents.push_back(&singleMother);
-        m_addedToLineage = false;
         this->initialize();
     }
     
-    // copy constructor
+    // copy constructor (the built brain is copied, not rebuilt)
     nAgent(const nAgent &o)
-    : m_id(o.m_id), m_parents(o.m_parents), m_genome(o.m_genome){ 
-        m_addedToLineage = o.m_addedToLineage;
+    : m_id(o.m_id), m_parents(o.m_parents), m_genome(o.m_genome), m_hmms(o.m_hmms),
+    m_deterministicUnits(o.m_deterministicUnits), m_stochasticUnits(o.m_stochasticUnits),
+    m_wideDeterministicUnits(o.m_wideDeterministicUnits), m_wideStochasticUnits(o.m_wideStochasticUnits){ 
         this->initialize();
     }
     
-    // assignment operator
-    nAgent& operator =(const nAgent o){
-        m_id = o.m_id;
-        m_parents = o.m_parents;
-        m_genome = o.m_genome;
-        m_addedToLineage = o.m_addedToLineage;
+    // move constructor (takes over the genome and the built brain)
+    nAgent(nAgent &&o)
+    : m_id(o.m_id), m_parents(std::move(o.m_parents)), m_genome(std::move(o.m_genome)), m_hmms(std::move(o.m_hmms)),
+    m_deterministicUnits(std::move(o.m_deterministicUnits)), m_stochasticUnits(std::move(o.m_stochasticUnits)),
+    m_wideDeterministicUnits(std::move(o.m_wideDeterministicUnits)), m_wideStochasticUnits(std::move(o.m_wideStochasticUnits)){
         this->initialize();
+    }
+    
+    // assignment operator
+    nAgent& operator =(const nAgent& o){
+        if (this != &o) {
+            m_id = o.m_id;
+            m_parents = o.m_parents;
+            m_genome = o.m_genome;
+            m_hmms = o.m_hmms;
+            m_deterministicUnits = o.m_deterministicUnits;
+            m_stochasticUnits = o.m_stochasticUnits;
+            m_wideDeterministicUnits = o.m_wideDeterministicUnits;
+            m_wideStochasticUnits = o.m_wideStochasticUnits;
+            this->initialize();
+        }
+        return *this;
+    }
+    
+    // move assignment operator
+    nAgent& operator =(nAgent&& o){
+        if (this != &o) {
+            m_id = o.m_id;
+            m_parents.swap(o.m_parents);
+            m_genome = std::move(o.m_genome);
+            m_hmms.swap(o.m_hmms);
+            m_deterministicUnits.swap(o.m_deterministicUnits);
+            m_stochasticUnits.swap(o.m_stochasticUnits);
+            m_wideDeterministicUnits.swap(o.m_wideDeterministicUnits);
+            m_wideStochasticUnits.swap(o.m_wideStochasticUnits);
+            this->initialize();
+        }
         return *this;
     }
  
@@ -127,54 +169,68 @@ public:
     { }
     
     // member functions
-    // initialize 
+    // initialize (the state of the agent; the brain is built from the genome by buildHMMs)
     void initialize(void);
     // is it a valid agent?
     bool isValid(void);
     // setup a random genome
-    void setupRandomGenome(unsigned int nucleotides = genomeLength);
+    void setupRandomGenome(unsigned int nucleotides = params.genomeLength);
     // setup the HMM units (from its genome)
     void buildHMMs(void);
+    // brains wider than a state word (kept in wide states, see nBrainState)
+    static bool wideBrain(void)                                                        { return params.maxNodes > stateWordBits; }
+    // is the built brain deterministic (a function of its state)
+    bool isDeterministic(void) const                                                   { return m_stochasticUnits.empty() && m_wideStochasticUnits.empty(); }
+    // canonical description of the built (deterministic) brain, false if stochastic
+    bool getPhenotype(std::vector<unsigned long>& phenotype) const;
     // load genome from a file
     void loadGenomeFromFile(std::fstream& genFile);
-    // load genome with given id from a file
+    // load genome of the agent with given id from a genome or LOD file (see nLOD)
     void loadGenomeFromFile(std::fstream& genFile, unsigned int id);
     // set parents
     void setParents(nAgent &parent1, nAgent &parent2);
     // get parents (by their IDs)
-    std::vector<nAgent*> getParents()                                                  { return m_parents; }
+    const std::vector<nAgent*>& getParents() const                                     { return m_parents; }
     // print parent by IDs
     void printParents(void);
-    // update the lineage
-    void updateLineage(int changeFactor, std::vector<unsigned int> accountedAncestors = std::vector<unsigned int>() );
-    // inherite (via cross-over) from given parents
+    // inherite (via cross-over) from given parents (brains not built yet)
     std::pair<nAgent, nAgent> crossOver(nAgent &partner);
-    // inherite (via mutation) from the given parent
+    // the same, the children numbered firstID and firstID + 1
+    std::pair<nAgent, nAgent> crossOver(nAgent &partner, unsigned int firstID);
+    // inherite (via mutation) from the given parent (brain not built yet)
     nAgent inheriteViaMutation(void);
-    // mutate (with given mutation rate)
-    void mutate(double rate = mutationRate);
-    // apply deletion
-    void applyDeletion(double rate = deletionRate);
-    // apply insertion
-    void applyInsertion(double rate = insertionRate);
+    // the same, the child numbered id
+    nAgent inheriteViaMutation(unsigned int id);
+    // inherite the genome of the given parent as it is (not mutated yet, brain not built)
+    nAgent inheriteGenome(void);
+    nAgent inheriteGenome(unsigned int id);
+    // inherite the genome and the built brain of the given parent as they are
+    nAgent inheriteAsClone(void);
+    // mutate (with given mutation rate; the genome only, see buildHMMs)
+    void mutate(double rate = params.mutationRate);
+    // apply deletion (the genome only)
+    void applyDeletion(double rate = params.deletionRate);
+    // apply insertion (the genome only)
+    void applyInsertion(double rate = params.insertionRate);
     // retire the agent (it dies)
     void retire(void)                                                                  { m_alive = false;  }
-    // declare as extinct (without any descendent)
-    void removeFromLineage(void);
     // print genome of the agent
     void printGenome(std::ostream& fout = std::cout);
     // print associated HMM units
     void printHMMUnits(std::ostream& fout = std::cout);
     // reset brain
-    void resetBrain(void)                                                              {  m_curState = 0; m_stateHistory.clear(); }
+    void resetBrain(void)                                                              {  m_curState = 0; m_curHighState = highState(); m_stateHistory.clear(); m_wideStateHistory.clear(); }
     // update brain state
     void updateBrain();
+    // update brain state (with deterministic or stochastic units, on a word or a wide state)
+    template<typename Kernel, typename State>
+    void updateBrainKernel(const std::vector<Kernel>& units, State& curState, State& prevState) const;
     // get the current brain state
     unsigned long getBrainState(void)                                                  { return m_curState; }
     // set brain state
     void setBrainState(unsigned long state)                                            { m_curState = state; }                      
     // get brain state history, so far
-    std::vector<std::pair<unsigned long, unsigned long> > getBrainHistory(void)        { return m_stateHistory; }
+    const std::vector<std::pair<unsigned long, unsigned long> >& getBrainHistory(void) const { return m_stateHistory; }
     // print brain state history
     void printBrainStateHistory(std::ostream& fout = std::cout, bool saveBinary = false);
     // get EEG scan for the brain
@@ -189,7 +245,7 @@ public:
     // reset fitness
     void resetFitness(void);
     // perform analysis
-    void analyze(bool scanBrain = useBrainScan, std::ostream* fout = &std::cout);
+    void analyze(bool scanBrain = params.useBrainScan, std::ostream* fout = &std::cout);
     
 };
 
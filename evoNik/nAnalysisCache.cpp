@@ -0,0 +1,65 @@
+//
+//  nAnalysisCache.cpp
+//  evoNik
+//
+
+#include "nAnalysisCache.hpp"
+
+nAnalysisCache::nAnalysisCache(const std::string& fileName){
+
+    // results of earlier analyses
+    std::ifstream previous(fileName.c_str());
+    std::string line;
+    while (getline(previous, line)) {
+        size_t tab = line.find('\t');
+        if (line.empty() || line[0] == '#' || tab == std::string::npos)
+            continue;
+        m_results[line.substr(0, tab)] = line.substr(tab + 1);
+    }
+    previous.close();
+
+    m_file.open(fileName.c_str(), std::ios::out | std::ios::app);
+    if (!m_file.is_open()) {
+        std::cerr << "Error in nAnalysisCache: can not open " << fileName << std::endl;
+        exit(1);
+    }
+    if (m_results.empty())
+        m_file << "# analysis parameters and brain phenotype\tresults" << std::endl;
+}
+
+
+bool nAnalysisCache::getKey(const nAgent& a, std::string& key){
+
+    std::vector<unsigned long> phenotype;
+    if (!a.getPhenotype(phenotype))
+        return false;
+
+    // the parameters the results depend on
+    std::ostringstream k;
+    k << params.maxNodes << ":" << params.useBrainScan << params.useTransitionMatrix << params.includeEnvUpdate
+    << params.gravityPresent << params.huntForFood << params.pruneNodes << ":" << params.agentDeficit
+    << ":" << params.calculateOverTimeDelays << ":" << params.approximatePhiAbove << ":" << params.phiSearchBudget << " ";
+
+    k << std::hex;
+    for (size_t i = 0; i < phenotype.size(); i++)
+        k << (i ? "," : "") << phenotype[i];
+
+    key = k.str();
+    return true;
+}
+
+
+const std::string* nAnalysisCache::find(const std::string& key){
+
+    boost::unordered_map<std::string, std::string>::const_iterator it = m_results.find(key);
+    return (it == m_results.end()) ? NULL : &it->second;
+}
+
+
+void nAnalysisCache::insert(const std::string& key, const std::string& results){
+
+    if (!m_results.insert(std::make_pair(key, results)).second)
+        return;
+
+    m_file << key << "\t" << results << std::endl;
+}
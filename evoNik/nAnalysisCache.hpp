@@ -0,0 +1,53 @@
+//
+//  nAnalysisCache.hpp
+//  evoNik
+//
+//  Brain analysis results (Phi, main complex, mutual informations, see
+//  nAnalyzer::run) keyed by the phenotype of the brain (the compiled HMM
+//  units, see nAgent::getPhenotype) and the parameters the analysis
+//  depends on. Long stretches of the line of descent carry the same
+//  brain; their analyses are done once. The results are kept in a file
+//  (in the run directory), one "key<tab>results" line each, read back
+//  when the cache is opened again (say, to reanalyse a line of descent
+//  at a finer interval). Stochastic brains are not cached. Not thread
+//  safe: nAnalysisQueue uses it from the submitting thread only.
+//
+
+#ifndef evoNik_nAnalysisCache_hpp
+#define evoNik_nAnalysisCache_hpp
+
+#include <string>
+
+#include <boost/unordered_map.hpp>
+
+#include "utility.hpp"
+#include "nAgent.hpp"
+
+class nAnalysisCache{
+public:
+
+    // constructor with the file the results are kept in (read, then appended to)
+    nAnalysisCache(const std::string& fileName);
+
+    // member functions
+    // key of the (built) brain of an agent, false if it can not be cached
+    static bool getKey(const nAgent& a, std::string& key);
+    // results for a key (NULL if not known)
+    const std::string* find(const std::string& key);
+    // store the results for a key
+    void insert(const std::string& key, const std::string& results);
+    // number of results held
+    size_t getSize(void)                                         { return m_results.size(); }
+
+private:
+    // results by key
+    boost::unordered_map<std::string, std::string> m_results;
+    // the file
+    std::fstream m_file;
+
+    // not copyable
+    nAnalysisCache(const nAnalysisCache&);
+    nAnalysisCache& operator = (const nAnalysisCache&);
+};
+
+#endif
@@ -16,6 +16,16 @@ void nAnalyzer::setRequirements(const char* requirements){
 
 
 void nAnalyzer::run(){
+    this->run(NULL);
+}
+
+
+void nAnalyzer::run(const std::string& brainResults){
+    this->run(&brainResults);
+}
+
+
+void nAnalyzer::run(const std::string* brainResults){
 
     // check requirements and throw a warning
     if (m_requirements.empty()) {
@@ -25,34 +35,30 @@ void nAnalyzer::run(){
     
     else{
 
-        if (std::find(m_requirements.begin(), m_requirements.end(), "all") != m_requirements.end() ||
-            std::find(m_requirements.begin(), m_requirements.end(), "collectData") != m_requirements.end())
-            // sample data for analysis
-            collectData();
-    
         if (std::find(m_requirements.begin(), m_requirements.end(), "all") != m_requirements.end() ||
             std::find(m_requirements.begin(), m_requirements.end(), "phi") != m_requirements.end())
-            // Perform phi-related calculation
-            calculatePhi();
-
-        for (unsigned int i = 0; i <= calculateOverTimeDelays; i++) {
-
-            if (std::find(m_requirements.begin(), m_requirements.end(), "all") != m_requirements.end() ||
-                std::find(m_requirements.begin(), m_requirements.end(), "ipred") != m_requirements.end())
-                // calculate predictive information
-                calculateMutualInfo(0, 0, i);
+            *m_analysisOutput << m_agent.m_id << "\t" << m_agent.m_fitness << "\t" << "\t";
 
-            if (std::find(m_requirements.begin(), m_requirements.end(), "all") != m_requirements.end() ||
-                std::find(m_requirements.begin(), m_requirements.end(), "smmi") != m_requirements.end())
-                // calculate sensory-motor mutual information (SMMI)
-                calculateMutualInfo(31, 3072, i);
-            
+        // results of the brain: reused, or worked out (and kept)
+        if (brainResults != NULL)
+            *m_analysisOutput << *brainResults;
+        else {
+            std::ostream* output = m_analysisOutput;
+            std::ostringstream brain;
+            m_analysisOutput = &brain;
+            analyzeBrain();
+            m_analysisOutput = output;
+            m_brainResults = brain.str();
+            *m_analysisOutput << m_brainResults;
         }
         
         if (std::find(m_requirements.begin(), m_requirements.end(), "all") != m_requirements.end() ||
             std::find(m_requirements.begin(), m_requirements.end(), "genLen") != m_requirements.end())
             // write genome lengths
             calculateGenomics();
+        
+        // were the brain results reused
+        *m_analysisOutput << (brainResults != NULL) << "\t";
     }
     
     // new line
@@ -60,6 +66,33 @@ void nAnalyzer::run(){
 }
 
 
+void nAnalyzer::analyzeBrain(){
+
+    if (std::find(m_requirements.begin(), m_requirements.end(), "all") != m_requirements.end() ||
+        std::find(m_requirements.begin(), m_requirements.end(), "collectData") != m_requirements.end())
+        // sample data for analysis
+        collectData();
+    
+    if (std::find(m_requirements.begin(), m_requirements.end(), "all") != m_requirements.end() ||
+        std::find(m_requirements.begin(), m_requirements.end(), "phi") != m_requirements.end())
+        // Perform phi-related calculation
+        calculatePhi();
+    
+    for (unsigned int i = 0; i <= params.calculateOverTimeDelays; i++) {
+
+        if (std::find(m_requirements.begin(), m_requirements.end(), "all") != m_requirements.end() ||
+            std::find(m_requirements.begin(), m_requirements.end(), "ipred") != m_requirements.end())
+            // calculate predictive information
+            calculateMutualInfo(0, 0, i);
+
+        if (std::find(m_requirements.begin(), m_requirements.end(), "all") != m_requirements.end() ||
+            std::find(m_requirements.begin(), m_requirements.end(), "smmi") != m_requirements.end())
+            // calculate sensory-motor mutual information (SMMI)
+            calculateMutualInfo(31, 3072, i);
+    }
+}
+
+
 void nAnalyzer::calculateGenomics(){
     // calculate uncompressed length
     std::stringstream uncompressedGenome;
@@ -79,6 +112,10 @@ void nAnalyzer::calculateGenomics(){
 
 void nAnalyzer::collectData(){
     
+    // exact transition probabilities need no data
+    if (haveTransitions(params.calculateOverTimeDelays))
+        return;
+    
     // if brain scan is not used
     // generate maze data
     if (!m_useBrainScan){
@@ -114,74 +151,143 @@ void nAnalyzer::collectData(){
     }    
 }
 
+// transitions of the given nodes over a (maze data or brain scan) history
+template<typename State>
+static void tabulateTransitions(const std::vector<std::pair<State, State> >& history, const std::vector<size_t>& nodes,
+                                unsigned int timeStepDelay, MT_TRANSITION_TABLE& transTable){
+    for (typename std::vector<std::pair<State, State> >::const_iterator it = history.begin();
+         it != history.end() - timeStepDelay; it++){
+        
+        MT_STATE x0state = MT_STATE(nodes.size(), projectState(it->first, nodes));
+        transTable[x0state.to_ulong()].push_back(MT_STATE(nodes.size(), projectState((it + timeStepDelay)->second, nodes)));
+    }
+}
+
+
+// write a partition of the given nodes as parts of the brain states
+template<typename State>
+static void writePartition(std::ostream& output, std::vector<State> brainP, const MT_PARTITION& P, const std::vector<size_t>& nodes){
+    for (size_t part = 0; part < P.size(); part++)
+        for (size_t i = 0; i < nodes.size(); i++)
+            if ((P[part] >> i) & 1)
+                setNode(brainP[part], (unsigned int)nodes[i]);
+    
+    for (size_t i=0; i < brainP.size(); ++i) {
+        output << brainP[i];
+        if (i+1 < brainP.size())
+            output <<",";
+    }
+}
+
+
 void nAnalyzer::calculatePhi(unsigned int timeStepDelay){
     
+    // initialize modularity toolset
+    ModularityToolset toolset;
+    
+    // entropy calculations
+    MT_ENTROPIES entropies;
     
     // collect data if not available
-    if (m_agent.m_stateHistory.empty())
+    bool exact = haveTransitions(timeStepDelay);
+    if (!exact && m_agent.m_stateHistory.empty())
         collectData();
     
-    // initialize modularity toolset
-    ModularityToolset toolset;
+    // the nodes that can be integrated (the network is reduced to them)
+    std::vector<size_t> nodes = activeNodes(timeStepDelay);
+    
+    // (a wide brain with more of them than a partition holds, a word: not analysed)
+    if (nodes.size() > stateWordBits) {
+        *m_analysisOutput << "nan" << "\t" << "\t" << "\t" << 0 << "\t";
+        return;
+    }
     
     // transition table
+    MT_WEIGHTED_TRANSITION_TABLE weightedTable;
     MT_TRANSITION_TABLE transTable;
     
-    for (std::vector<std::pair<unsigned long, unsigned long> >::iterator it = m_agent.m_stateHistory.begin();
-         it != m_agent.m_stateHistory.end() - timeStepDelay; it++){
-        
-        MT_STATE x0state = MT_STATE(maxNodes, it->first);
-        transTable[x0state.to_ulong()].push_back(MT_STATE(maxNodes, (it + timeStepDelay)->second));
-    }    
+    if (exact)
+        // from the transition probabilities
+        weightedTable = m_transitions[timeStepDelay].getTransitionTable(nodes);
     
-    // entropy calculations
-    MT_ENTROPIES entropies = toolset.entropies(transTable);
+    // from the whole states of a wide brain
+    else if (nAgent::wideBrain())
+        tabulateTransitions(m_agent.m_wideStateHistory, nodes, timeStepDelay, transTable);
     
-    // MIP
-    //std::vector<MT_PARTITION> MIP = toolset.MIPs(entropies, ENM_TONONI_BALDUZZI);
+    else
+        tabulateTransitions(m_agent.m_stateHistory, nodes, timeStepDelay, transTable);
     
-    // Phi
-    //double Phi = toolset.ei(MIP[0], ENM_NONE, entropies);
+    double phiMC;
+    std::vector<size_t> thisMC;
+    MT_PARTITION ei_max_P;
+    // partitions evaluated for the MIP (exhaustively: of every subset searched for the main complex)
+    unsigned long evaluated;
     
-    // main complex
-    std::pair<std::vector<std::vector<size_t> >,double> mainComplexes = toolset.mainComplexes(totalPartition(maxNodes),
-                                                                                              entropies,
-                                                                                              ENM_TONONI_BALDUZZI);    
+    // too many nodes to run over all their subsets and partitions: approximate MIP of all of them
+    if (nodes.size() > params.approximatePhiAbove) {
+        MT_MIP_SEARCH search = exact
+        ? toolset.approximateMIP(weightedTable, nodes.size(), ENM_TONONI_BALDUZZI, params.phiSearchBudget)
+        : toolset.approximateMIP(transTable, ENM_TONONI_BALDUZZI, params.phiSearchBudget);
+        
+        phiMC = search.ei;
+        ei_max_P = search.MIP;
+        evaluated = search.visited;
+        for (size_t i = 0; i < nodes.size(); i++)
+            thisMC.push_back(i);
+    }
     
-    // Phi of main complex
-    double ei_max(-1.0);
-    int ei_max_mcI(-1);
-    MT_PARTITION ei_max_P;
-    for (unsigned int mcI = 0; mcI < mainComplexes.first.size(); mcI++) {
-        std::vector<MT_PARTITION > MIPs = toolset.MIPs( mainComplexes.first[mcI],
-                                                       entropies,
-                                                       ENM_TONONI_BALDUZZI);
-        
-        for (unsigned int mipI = 0; mipI < MIPs.size(); mipI++) {
-            double ei_temp = toolset.ei(mainComplexes.first[mcI],
-                                        MIPs[mipI],
-                                        ENM_NONE,
-                                        entropies);
-            if (ei_temp >  ei_max) {
-                ei_max = ei_temp;
-                ei_max_mcI = mcI;
-                ei_max_P = MIPs[mipI];
+    else {
+        entropies = exact ? toolset.entropies(weightedTable, nodes.size()) : toolset.entropies(transTable);
+        
+        // MIP
+        //std::vector<MT_PARTITION> MIP = toolset.MIPs(entropies, ENM_TONONI_BALDUZZI);
+        
+        // Phi
+        //double Phi = toolset.ei(MIP[0], ENM_NONE, entropies);
+        
+        // main complex
+        std::pair<std::vector<std::vector<size_t> >,double> mainComplexes = toolset.mainComplexes(totalPartition(nodes.size()),
+                                                                                                  entropies,
+                                                                                                  ENM_TONONI_BALDUZZI);    
+        
+        // Phi of main complex
+        double ei_max(-1.0);
+        int ei_max_mcI(-1);
+        for (unsigned int mcI = 0; mcI < mainComplexes.first.size(); mcI++) {
+            std::vector<MT_PARTITION > MIPs = toolset.MIPs( mainComplexes.first[mcI],
+                                                           entropies,
+                                                           ENM_TONONI_BALDUZZI);
+            
+            for (unsigned int mipI = 0; mipI < MIPs.size(); mipI++) {
+                double ei_temp = toolset.ei(mainComplexes.first[mcI],
+                                            MIPs[mipI],
+                                            ENM_NONE,
+                                            entropies);
+                if (ei_temp >  ei_max) {
+                    ei_max = ei_temp;
+                    ei_max_mcI = mcI;
+                    ei_max_P = MIPs[mipI];
+                }
             }
         }
+        
+        phiMC = ei_max;
+        thisMC = mainComplexes.first[ei_max_mcI];
+        evaluated = toolset.partitions_evaluated;
     }
     
-    double phiMC = ei_max;
-    std::vector<size_t> thisMC = mainComplexes.first[ei_max_mcI];
+    // back to the nodes of the brain
+    for (size_t i = 0; i < thisMC.size(); i++)
+        thisMC[i] = nodes[thisMC[i]];
     
     // write to file
-    *m_analysisOutput << m_agent.m_id << "\t" << m_agent.m_fitness << "\t" << "\t" << phiMC << "\t";
+    *m_analysisOutput << phiMC << "\t";
     
-    // 
-    for (size_t i=0; i < ei_max_P.size(); ++i) {
-        *m_analysisOutput << ei_max_P[i];
-        if (i+1 < ei_max_P.size())
-            *m_analysisOutput <<",";
-    }
+    // (one part per node of a brain state word; the parts found for a wide brain)
+    if (nAgent::wideBrain())
+        writePartition(*m_analysisOutput, std::vector<wideState>(ei_max_P.size()), ei_max_P, nodes);
+    else
+        writePartition(*m_analysisOutput, MT_PARTITION(params.maxNodes, 0), ei_max_P, nodes);
     
     *m_analysisOutput << "\t";
     
@@ -192,45 +298,295 @@ void nAnalyzer::calculatePhi(unsigned int timeStepDelay){
             *m_analysisOutput <<",";
     }
     *m_analysisOutput << "\t";
+    
+    // partitions evaluated for the MIP
+    *m_analysisOutput << evaluated << "\t";
         
 }
 
 
 
-void nAnalyzer::calculateMutualInfo(unsigned long xMask, unsigned long yMask, unsigned int timeStepDelay){
-    
-    // construct probability table
-    std::map<std::pair<unsigned long, unsigned long>, double> freqTable;
-    std::map<unsigned long, double> numInputOccurrence;
-    for (std::vector<std::pair<unsigned long, unsigned long> >::iterator it = m_agent.m_stateHistory.begin();
-         it != m_agent.m_stateHistory.end() - timeStepDelay; it++) {
+// count the (masked: a zero mask keeps all) transitions over a history
+template<typename State>
+static void countTransitions(const std::vector<std::pair<State, State> >& history, State xMask, State yMask, unsigned int timeStepDelay,
+                             std::map<std::pair<State, State>, double>& freqTable, std::map<State, double>& numInputOccurrence){
+    for (typename std::vector<std::pair<State, State> >::const_iterator it = history.begin();
+         it != history.end() - timeStepDelay; it++) {
         //    frequencyTable
-        unsigned long input = (xMask) ? (it->first&xMask) : it->first;
-        unsigned long output = (yMask) ? ((it + timeStepDelay)->second&yMask) : (it + timeStepDelay)->second;
+        State input = (xMask != State()) ? (it->first&xMask) : it->first;
+        State output = (yMask != State()) ? ((it + timeStepDelay)->second&yMask) : (it + timeStepDelay)->second;
         freqTable[std::make_pair(input, output)]++;
         numInputOccurrence[input]++;
     }
+}
+
+
+// mutual information of the inputs and outputs of counted transitions
+template<typename State>
+static double mutualInformation(std::map<std::pair<State, State>, double>& freqTable, std::map<State, double>& numInputOccurrence,
+                                double numObservations){
     
     // normalize each input transition
     // and also calculate p(out)
-    std::map<unsigned long, double> outProb;
-    for (std::map<std::pair<unsigned long, unsigned long>, double>::iterator it = freqTable.begin();
+    std::map<State, double> outProb;
+    for (typename std::map<std::pair<State, State>, double>::iterator it = freqTable.begin();
          it != freqTable.end(); it++) {
         // p(y|x)
         it->second /= numInputOccurrence[(it->first).first];
         // p(y) = \sum p(in) * p(out | in)
-        outProb[(it->first).second] += (numInputOccurrence[(it->first).first] / m_agent.m_stateHistory.size() ) * it->second; 
+        outProb[(it->first).second] += (numInputOccurrence[(it->first).first] / numObservations ) * it->second; 
     }
     
     // mutual information
     double mutInfo(0.0);
-    for (std::map<std::pair<unsigned long, unsigned long>, double>::iterator it = freqTable.begin();
+    for (typename std::map<std::pair<State, State>, double>::iterator it = freqTable.begin();
          it != freqTable.end(); it++) {
         // p(x)
-        double pX = numInputOccurrence[(it->first).first] / m_agent.m_stateHistory.size();
+        double pX = numInputOccurrence[(it->first).first] / numObservations;
         // mutInfo = \sum p(x)*p(y|x) \log [ p(y|x) / p(y) ]
         mutInfo += pX * (it->second) * log( (it->second) / outProb[(it->first).second] ) / log(2);
     }
     
-    *m_analysisOutput << mutInfo << "\t";
+    return mutInfo;
+}
+
+
+void nAnalyzer::calculateMutualInfo(unsigned long xMask, unsigned long yMask, unsigned int timeStepDelay){
+    
+    // the whole states of a wide brain (the masks are on their first word)
+    if (nAgent::wideBrain() && !haveTransitions(timeStepDelay)) {
+        std::map<std::pair<wideState, wideState>, double> freqTable;
+        std::map<wideState, double> numInputOccurrence;
+        countTransitions(m_agent.m_wideStateHistory, wideState(xMask), wideState(yMask), timeStepDelay, freqTable, numInputOccurrence);
+        
+        *m_analysisOutput << mutualInformation(freqTable, numInputOccurrence, (double)m_agent.m_wideStateHistory.size()) << "\t";
+        return;
+    }
+    
+    // construct probability table
+    std::map<std::pair<unsigned long, unsigned long>, double> freqTable;
+    std::map<unsigned long, double> numInputOccurrence;
+    double numObservations(0.0);
+    
+    if (haveTransitions(timeStepDelay)) {
+        // every state once, followed by its next states (weighted by their probability)
+        const nTransitionMatrix& transitions = m_transitions[timeStepDelay];
+        for (unsigned long state = 0; state < (1UL << params.maxNodes); state++) {
+            unsigned long input = (xMask) ? (state&xMask) : state;
+            const nTransitionMatrix::row& next = transitions.getRow(state);
+            for (nTransitionMatrix::row::const_iterator it = next.begin(); it != next.end(); it++) {
+                unsigned long output = (yMask) ? (it->first&yMask) : it->first;
+                freqTable[std::make_pair(input, output)] += it->second;
+                numInputOccurrence[input] += it->second;
+            }
+            numObservations++;
+        }
+    }
+    
+    else {
+        countTransitions(m_agent.m_stateHistory, xMask, yMask, timeStepDelay, freqTable, numInputOccurrence);
+        numObservations = m_agent.m_stateHistory.size();
+    }
+    
+    *m_analysisOutput << mutualInformation(freqTable, numInputOccurrence, numObservations) << "\t";
+}
+
+
+std::vector<size_t> nAnalyzer::activeNodes(unsigned int timeStepDelay){
+    
+    // over the whole states of a wide brain
+    if (nAgent::wideBrain())
+        return activeNodes(m_agent.m_wideStateHistory, timeStepDelay);
+    return activeNodes(m_agent.m_stateHistory, timeStepDelay);
+}
+
+
+template<typename State>
+std::vector<size_t> nAnalyzer::activeNodes(const std::vector<std::pair<State, State> >& history, unsigned int timeStepDelay){
+    
+    bool exact = haveTransitions(timeStepDelay);
+    
+    // nodes wired to a unit (as an input or an output); a node wired to none is left out
+    // if the data start from every state alike (in maze data it may still be correlated
+    // with the others through the maze)
+    State wired = State();
+    for (std::vector<nHMMUnit>::iterator unit = m_agent.m_hmms.begin(); unit != m_agent.m_hmms.end(); unit++) {
+        for (size_t i = 0; i < unit->m_inputs.size(); i++)
+            setNode(wired, unit->m_inputs[i]);
+        for (size_t i = 0; i < unit->m_outputs.size(); i++)
+            setNode(wired, unit->m_outputs[i]);
+    }
+    if (!exact && !m_useBrainScan)
+        wired = ~State();
+    
+    // nodes varying over the data (the exact transitions start from every state)
+    State varying = ~State();
+    if (!exact && history.size() > timeStepDelay) {
+        State varying0 = State(), varying1 = State();
+        for (size_t t = 0; t + timeStepDelay < history.size(); t++) {
+            varying0 |= history[t].first ^ history[0].first;
+            varying1 |= history[t + timeStepDelay].second ^ history[timeStepDelay].second;
+        }
+        varying = varying0 | varying1;
+    }
+    
+    std::vector<size_t> nodes;
+    for (size_t node = 0; node < params.maxNodes; node++)
+        if (!params.pruneNodes || stateBit(wired & varying, (unsigned int)node))
+            nodes.push_back(node);
+    
+    // nothing to integrate: the whole brain
+    if (nodes.size() < 2) {
+        nodes.resize(params.maxNodes);
+        for (size_t node = 0; node < params.maxNodes; node++)
+            nodes[node] = node;
+    }
+    
+    return nodes;
+}
+
+
+bool nAnalyzer::haveTransitions(unsigned int timeStepDelay){
+    
+    if (!m_useTransitionMatrix)
+        return false;
+    
+    // one time step, the rest one after the other
+    if (m_transitions.empty())
+        m_transitions.push_back(nTransitionMatrix(m_agent));
+    
+    while (m_transitions.back().isValid() && m_transitions.size() <= timeStepDelay)
+        m_transitions.push_back(m_transitions.back().then(m_transitions.front()));
+    
+    // too many transitions (or nodes): sample them (maze data or brain scan) instead
+    if (!m_transitions.back().isValid())
+        m_useTransitionMatrix = false;
+    
+    return m_useTransitionMatrix;
+}
+
+
+void nAnalysisQueue::submit(unsigned int genID, unsigned int agentID, const nGenome& genome, double fitness){
+    
+    boost::shared_ptr<job> j(new job);
+    j->genID = genID;
+    j->agentID = agentID;
+    j->genome = genome;
+    j->fitness = fitness;
+    j->done = false;
+    j->reused = false;
+    
+    // a brain analysed before, or being analysed for an earlier job
+    if (m_cache != NULL) {
+        nAgent brain(agentID);
+        brain.m_genome = genome;
+        brain.buildHMMs();
+        
+        if (nAnalysisCache::getKey(brain, j->key)) {
+            const std::string* results = m_cache->find(j->key);
+            std::map<std::string, boost::shared_ptr<job> >::iterator pending = m_pendingKeys.find(j->key);
+            
+            if (results != NULL) {
+                j->brainResults = *results;
+                j->reused = true;
+            }
+            else if (pending != m_pendingKeys.end()) {
+                j->source = pending->second;
+                j->reused = true;
+            }
+            else
+                m_pendingKeys[j->key] = j;
+        }
+    }
+    
+    m_jobs.push_back(j);
+    
+    // analyze in place, or let the scheduler find a core for it
+    // (reusing the results of an earlier job once it is written out)
+    if (m_scheduler == NULL || (j->reused && !j->source))
+        analyze(j);
+    else if (!j->source)
+        m_scheduler->submit(boost::bind(&nAnalysisQueue::analyze, this, j), true);
+    
+    flush();
+}
+
+
+void nAnalysisQueue::note(const std::string& line){
+    
+    boost::shared_ptr<job> j(new job);
+    j->genID = j->agentID = 0;
+    j->fitness = 0;
+    j->reused = false;
+    j->output << line << std::endl;
+    j->done = true;
+    
+    m_jobs.push_back(j);
+    flush();
+}
+
+
+void nAnalysisQueue::flush(bool waitForAll){
+    
+    while (!m_jobs.empty()) {
+        
+        boost::unique_lock<boost::mutex> lock(m_mutex);
+        
+        // the earlier job it reuses the results of is written out already
+        if (!m_jobs.front()->done && m_jobs.front()->source) {
+            lock.unlock();
+            analyze(m_jobs.front());
+            continue;
+        }
+        
+        if (!m_jobs.front()->done) {
+            if (!waitForAll)
+                return;
+            
+            // help out with pending analyses (not a queued replicate), or wait for the job to finish
+            lock.unlock();
+            if (m_scheduler == NULL || !m_scheduler->runPendingJob(true)){
+                lock.lock();
+                while (!m_jobs.front()->done)
+                    m_jobDone.wait(lock);
+            }
+            continue;
+        }
+        
+        // keep the brain results worked out
+        boost::shared_ptr<job> j = m_jobs.front();
+        if (m_cache != NULL && !j->key.empty() && !j->reused) {
+            m_cache->insert(j->key, j->brainResults);
+            m_pendingKeys.erase(j->key);
+        }
+        
+        *m_analysisOutput << j->output.str();
+        m_jobs.pop_front();
+    }
+    
+    m_analysisOutput->flush();
+}
+
+
+void nAnalysisQueue::analyze(boost::shared_ptr<job> j){
+    
+    // isolate the analysis from the random state and the id counters
+    // of whatever run is being executed by the calling thread
+    nRunContext analysisContext;
+    nRunContext::scope contextScope(analysisContext);
+    nRandomStream randomStream(j->genID ^ (j->agentID << 16));
+    
+    j->output << j->genID << "\t";
+    nAnalyzer analyzer(j->agentID, j->genome, j->fitness, j->output);
+    analyzer.setRequirements("all");
+    if (!j->reused) {
+        analyzer.run();
+        j->brainResults = analyzer.getBrainResults();
+    }
+    else
+        analyzer.run(j->source ? j->source->brainResults : j->brainResults);
+    
+    boost::lock_guard<boost::mutex> lock(m_mutex);
+    j->done = true;
+    m_jobDone.notify_all();
 }
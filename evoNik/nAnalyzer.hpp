@@ -9,10 +9,16 @@
 #ifndef evoNik_nAnalyzer_hpp
 #define evoNik_nAnalyzer_hpp
 
+#include <deque>
+#include <map>
+
 #include "utility.hpp"
+#include "nScheduler.hpp"
 #include "nAgent.hpp"
 #include "nMaze.hpp"
 #include "nGame.hpp"
+#include "nTransitionMatrix.hpp"
+#include "nAnalysisCache.hpp"
 #include "ModularityToolset/ModularityToolset.h"
 #include "ModularityToolset/PartitionEnumerator.h"
 
@@ -27,14 +33,17 @@ public:
     std::ostream* m_analysisOutput;
     // use brainScan or mazeData
     bool m_useBrainScan;
+    // use the exact transition probabilities of the brain (instead of either)
+    bool m_useTransitionMatrix;
     // list of requirements
     std::vector<std::string> m_requirements;
     
     
     // constructor
-    nAnalyzer(unsigned int playerID, nGenome playerGenome, double playerFitness, std::ostream& output = std::cout, bool scanBrain = useBrainScan)
+    nAnalyzer(unsigned int playerID, nGenome playerGenome, double playerFitness, std::ostream& output = std::cout, bool scanBrain = params.useBrainScan)
     : m_analysisOutput(&output),
-    m_useBrainScan(useBrainScan){
+    m_useBrainScan(params.useBrainScan),
+    m_useTransitionMatrix(params.useTransitionMatrix && params.maxNodes <= exhaustiveNodesLimit){
         m_agent.m_id = playerID;
         m_agent.m_genome = playerGenome;
         m_agent.m_fitness = playerFitness;
@@ -55,6 +64,12 @@ public:
     void setRequirements(const char* requirements);
     // run analysis
     void run(void);
+    // run analysis with the brain results (Phi, MI, ...) of an earlier analysis of the same brain
+    void run(const std::string& brainResults);
+    // brain results of the last run (if worked out)
+    const std::string& getBrainResults(void)                     { return m_brainResults; }
+    // the brain results (Phi, main complex, MI, ...: all but the genomics)
+    void analyzeBrain(void);
     // print genomic details
     void calculateGenomics(void);
     // collect data for analysis
@@ -65,6 +80,91 @@ public:
     void calculateMutualInfo(unsigned long xMask = 0, unsigned long yMask = 0, unsigned int timeStepDelay = 0);
     
     void analyze(bool test) { }
+
+private:
+    // transitions over 1, 2, ... time steps (as far as needed so far)
+    std::vector<nTransitionMatrix> m_transitions;
+    // brain results of the last run
+    std::string m_brainResults;
+
+    // run analysis (with given brain results, if not NULL)
+    void run(const std::string* brainResults);
+
+    // are the transitions over timeStepDelay + 1 time steps to be used (worked out if so)
+    bool haveTransitions(unsigned int timeStepDelay = 0);
+    // nodes that can be part of a complex: not constant over the data and (for exact
+    // transitions or a brain scan) wired to a unit; a complex with any other node in it
+    // has a MIP cutting that node off at no information, hence Phi 0
+    std::vector<size_t> activeNodes(unsigned int timeStepDelay = 0);
+    // the same over a history (of one word or wide states)
+    template<typename State>
+    std::vector<size_t> activeNodes(const std::vector<std::pair<State, State> >& history, unsigned int timeStepDelay);
+};
+
+
+// analyses of (LOD) agents, run in place or off-loaded to a scheduler;
+// results are written to the output in the order of submission. With a
+// cache, an agent whose brain was analysed before (or is being analysed
+// for an earlier submission) reuses those brain results
+class nAnalysisQueue{
+public:
+    
+    // constructor
+    nAnalysisQueue(std::ostream& output, nScheduler* scheduler = NULL, nAnalysisCache* cache = NULL)
+    : m_analysisOutput(&output),
+    m_scheduler(scheduler),
+    m_cache(cache){
+    }
+    
+    // destructor
+    ~nAnalysisQueue(){
+        flush(true);
+    }
+    
+    // member functions
+    // analyze an agent of the given generation
+    void submit(unsigned int genID, unsigned int agentID, const nGenome& genome, double fitness);
+    // write a (comment) line in between the analyses, in order of submission
+    void note(const std::string& line);
+    // write out the finished analyses (optionally wait for all of them)
+    void flush(bool waitForAll = false);
+    
+private:
+    // a pending analysis
+    struct job{
+        unsigned int genID, agentID;
+        nGenome genome;
+        double fitness;
+        std::ostringstream output;
+        bool done;
+        // cache key of the brain (empty: not cached)
+        std::string key;
+        // brain results: worked out, or reused (from the cache or an earlier job)
+        std::string brainResults;
+        bool reused;
+        boost::shared_ptr<job> source;
+    };
+    
+    // the analysis output
+    std::ostream* m_analysisOutput;
+    // scheduler (NULL: analyze in place)
+    nScheduler* m_scheduler;
+    // brain results of earlier analyses (NULL: none kept)
+    nAnalysisCache* m_cache;
+    // pending analyses (in submission order)
+    std::deque<boost::shared_ptr<job> > m_jobs;
+    // pending analyses working out the results of a brain (by cache key)
+    std::map<std::string, boost::shared_ptr<job> > m_pendingKeys;
+    // synchronization
+    boost::mutex m_mutex;
+    boost::condition_variable m_jobDone;
+    
+    // run the analysis of a job
+    void analyze(boost::shared_ptr<job> j);
+    
+    // not copyable
+    nAnalysisQueue(const nAnalysisQueue&);
+    nAnalysisQueue& operator = (const nAnalysisQueue&);
 };
 
 
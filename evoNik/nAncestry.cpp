@@ -0,0 +1,268 @@
+//
+//  nAncestry.cpp
+//  evoNik
+//
+
+#include "nAncestry.hpp"
+
+nAncestry::~nAncestry(){
+    for (std::vector<row>::iterator it = m_rows.begin(); it != m_rows.end(); it++)
+        if (it->held && it->agent != NULL) {
+            delete it->agent;
+            PROFILE_COUNT(COUNT_AGENTS_FREED, 1);
+        }
+}
+
+
+void nAncestry::add(nAgent& a, unsigned int genID){
+
+    if (m_generations.empty())
+        m_firstGenID = genID;
+
+    if (genID < m_firstGenID) {
+        std::cerr << "Error in nAncestry: agent # " << a.m_id << " born in generation "
+        << genID << ", which is already resolved!" << std::endl;
+        exit(1);
+    }
+
+    if (a.m_parents.size() > 2) {
+        std::cerr << "Error in nAncestry: agent # " << a.m_id << " has more than two parents" << std::endl;
+        exit(1);
+    }
+
+    // open the generations up to this one
+    while (m_firstGenID + m_generations.size() <= genID) {
+        m_generations.push_back(generation());
+        m_generations.back().held = 0;
+        m_generations.back().heldSum = 0;
+        m_generations.back().orphans = 0;
+    }
+
+    row n;
+    n.id = a.m_id;
+    n.generation = genID;
+    n.liveDescendants = 0;
+    n.fitness = 0;
+    n.endState = 0;
+    n.endHighState = highState();
+    n.genomeOffset = 0;
+    n.genomeLength = 0;
+    n.agent = &a;
+    n.held = true;
+    n.orphan = true;
+    n.origin = a.m_origin;
+
+    // one more descendant for each parent (the ones resolved already are the LOD)
+    for (size_t i = 0; i < 2; i++) {
+        n.parents[i] = noRow;
+        n.parentIDs[i] = 0;
+        if (i < a.m_parents.size() && isHeld(a.m_parents[i]->m_ancestryRow, a.m_parents[i]->m_id)) {
+            n.parents[i] = a.m_parents[i]->m_ancestryRow;
+            n.parentIDs[i] = a.m_parents[i]->m_id;
+            m_rows[n.parents[i]].liveDescendants++;
+            n.orphan = false;
+        }
+    }
+
+    // a dropped row, or a new one
+    unsigned int r;
+    if (!m_freeRows.empty()) {
+        r = m_freeRows.back();
+        m_freeRows.pop_back();
+        m_rows[r] = n;
+    }
+    else {
+        r = (unsigned int)m_rows.size();
+        m_rows.push_back(n);
+    }
+
+    generation& g = m_generations[genID - m_firstGenID];
+    g.held++;
+    g.heldSum += r;
+    m_size++;
+    if (n.orphan) {
+        g.orphans++;
+        m_orphans++;
+    }
+
+    a.m_generation = genID;
+    a.m_ancestryRow = r;
+
+    // (the parents are held as rows from now on, and may be freed)
+    a.m_parents.clear();
+}
+
+
+void nAncestry::retire(nAgent& a){
+    a.retire();
+
+    unsigned int r = a.m_ancestryRow;
+    if (isHeld(r, a.m_id) && m_rows[r].agent == &a) {
+        // what is left of it
+        row& dead = m_rows[r];
+        dead.agent = NULL;
+        dead.fitness = a.m_fitness;
+        dead.endState = a.m_curState;
+        dead.endHighState = a.m_curHighState;
+        dead.endMove = a.m_prevPosition;
+
+        if (dead.liveDescendants == 0)
+            reclaim(r);
+        else {
+            // (a possible LOD entry)
+            dead.genomeOffset = m_genes.size();
+            dead.genomeLength = (unsigned int)a.m_genome.getSize();
+            m_genes.insert(m_genes.end(), a.m_genome.m_genome.begin(), a.m_genome.m_genome.end());
+        }
+    }
+
+    delete &a;
+    PROFILE_COUNT(COUNT_AGENTS_FREED, 1);
+}
+
+
+void nAncestry::drop(unsigned int r){
+
+    row& dropped = m_rows[r];
+    generation& g = m_generations[dropped.generation - m_firstGenID];
+    g.held--;
+    g.heldSum -= r;
+    m_size--;
+    if (dropped.orphan) {
+        g.orphans--;
+        m_orphans--;
+    }
+
+    dropped.held = false;
+    m_freeRows.push_back(r);
+
+    // its genes are no longer needed
+    if (dropped.genomeLength != 0) {
+        m_droppedGenes += dropped.genomeLength;
+        dropped.genomeLength = 0;
+        if (2*m_droppedGenes > m_genes.size())
+            compact();
+    }
+}
+
+
+void nAncestry::reclaim(unsigned int r){
+
+    std::vector<unsigned int> extinct(1, r);
+
+    while (!extinct.empty()) {
+        unsigned int e = extinct.back();
+        extinct.pop_back();
+
+        // the parents lose a descendant (and may go extinct as well)
+        for (size_t i = 0; i < 2; i++) {
+            unsigned int p = m_rows[e].parents[i];
+            if (isHeld(p, m_rows[e].parentIDs[i]) &&
+                --m_rows[p].liveDescendants == 0 && m_rows[p].agent == NULL)
+                extinct.push_back(p);
+        }
+
+        drop(e);
+    }
+}
+
+
+void nAncestry::compact(void){
+
+    std::vector<unsigned int> genes;
+    genes.reserve(m_genes.size() - m_droppedGenes);
+
+    for (std::vector<row>::iterator it = m_rows.begin(); it != m_rows.end(); it++)
+        if (it->held && it->genomeLength != 0) {
+            std::vector<unsigned int>::iterator first = m_genes.begin() + it->genomeOffset;
+            it->genomeOffset = genes.size();
+            genes.insert(genes.end(), first, first + it->genomeLength);
+        }
+
+    m_genes.swap(genes);
+    m_droppedGenes = 0;
+}
+
+
+void nAncestry::handOut(unsigned int genID, unsigned int r){
+
+    if (!m_entryHandler)
+        return;
+
+    const row& a = m_rows[r];
+    if (a.agent != NULL) {
+        m_entryHandler(genID, *a.agent);
+        return;
+    }
+
+    // the agent made again: genome, brain and the state it died in
+    nAgent ancestor(a.id);
+    ancestor.m_genome.m_genome.assign(m_genes.begin() + a.genomeOffset,
+                                      m_genes.begin() + a.genomeOffset + a.genomeLength);
+    ancestor.buildHMMs();
+    ancestor.m_fitness = a.fitness;
+    ancestor.m_curState = a.endState;
+    ancestor.m_curHighState = a.endHighState;
+    ancestor.m_prevPosition = a.endMove;
+    ancestor.m_origin = a.origin;
+    ancestor.retire();
+
+    m_entryHandler(genID, ancestor);
+}
+
+
+void nAncestry::coalesce(unsigned int genID){
+
+    while (!m_generations.empty() && m_firstGenID < genID) {
+
+        // not (yet) coalesced
+        if (m_generations.front().held > 1)
+            break;
+
+        // a newer lineage that does not descend from this generation (an
+        // immigrant's): wait until it dies out, or is all that is left
+        if (m_generations.front().held == 1 && m_orphans > m_generations.front().orphans)
+            break;
+
+        // record the ancestor, if any left
+        if (m_generations.front().held == 1) {
+            unsigned int ancestor = (unsigned int)m_generations.front().heldSum;
+            handOut(m_firstGenID, ancestor);
+
+            // (its children start the remaining, unresolved, lineage)
+            drop(ancestor);
+        }
+
+        m_generations.pop_front();
+        m_firstGenID++;
+    }
+}
+
+
+unsigned int nAncestry::lineageParent(unsigned int r){
+
+    unsigned int parent = noRow;
+    for (size_t i = 0; i < 2; i++)
+        if (isHeld(m_rows[r].parents[i], m_rows[r].parentIDs[i]) &&
+            (parent == noRow || m_rows[m_rows[r].parents[i]].generation > m_rows[parent].generation))
+            parent = m_rows[r].parents[i];
+
+    return parent;
+}
+
+
+void nAncestry::resolveLineage(unsigned int genID, nAgent& a){
+
+    // the youngest parents, back to the oldest held generation
+    std::vector<unsigned int> lineage;
+    if (isHeld(a.m_ancestryRow, a.m_id))
+        for (unsigned int r = lineageParent(a.m_ancestryRow); r != noRow; r = lineageParent(r))
+            lineage.push_back(r);
+
+    // oldest first
+    for (size_t i = lineage.size(); i-- > 0; )
+        handOut(genID - 1 - (unsigned int)i, lineage[i]);
+
+    if (m_entryHandler)
+        m_entryHandler(genID, a);
+}
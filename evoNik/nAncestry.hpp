@@ -0,0 +1,146 @@
+//
+//  nAncestry.hpp
+//  evoNik
+//
+//  The ancestry of a run as a DAG of compact rows (id, parents,
+//  fitness, genome offset), counted by generation: the agents
+//  themselves are freed as they die (retire), their rows stay. Every
+//  held row counts its direct descendants still held; a dead row
+//  without such descendants is dropped, and so on down the lineage
+//  (cascading decrements). Only dead rows with descendants keep their
+//  genome (in a shared pool of genes, compacted as rows are dropped):
+//  they are the ones which may still become entries of the line of
+//  descent. Whenever the oldest held generation is down to a single
+//  row, that row is the most recent common ancestor of everything
+//  newer: it is handed out as the next entry of the line of descent
+//  (LOD), as an agent made again from the row, and dropped. (A row
+//  may be younger than some of its parents, see nSteadyState, as long
+//  as one of them is of the generation right before.) A row born
+//  without parents after the first generation (an immigrant, see
+//  nPopulation::immigrate) descends from no held row: while it is held,
+//  the older generations are not coalesced, as no row of theirs is an
+//  ancestor of it. Should its lineage take over, those generations have
+//  no ancestor here: the entries jump to it (its row keeps the island,
+//  id and generation it comes from, see nLOD::crossing).
+//  Dropped rows are reused, so the store is as large as the lineage
+//  still unresolved (not as all the agents born since).
+//
+
+#ifndef evoNik_nAncestry_hpp
+#define evoNik_nAncestry_hpp
+
+#include <deque>
+#include <vector>
+
+#include <boost/function.hpp>
+
+#include "utility.hpp"
+#include "nAgent.hpp"
+
+class nAncestry{
+public:
+
+    // receives every resolved LOD entry (generation id, the ancestor), oldest first
+    typedef boost::function<void (unsigned int, nAgent&)> entryHandler;
+
+    // constructor
+    nAncestry()
+    : m_firstGenID(0),
+    m_size(0),
+    m_orphans(0),
+    m_droppedGenes(0){
+    }
+
+    // destructor (frees the agents still alive)
+    ~nAncestry();
+
+    // member functions
+    // set the receiver of LOD entries
+    void setEntryHandler(entryHandler handler)                  { m_entryHandler = handler; }
+    // register a newborn of a generation (its parents must be held; the ancestry owns it from now on)
+    void add(nAgent& a, unsigned int genID);
+    // the agent dies: it is freed (its row is kept while it has held descendants)
+    void retire(nAgent& a);
+    // resolve the LOD entries of the generations older than genID
+    void coalesce(unsigned int genID);
+    // hand out a held agent (as of generation genID) after its unresolved ancestors, oldest first
+    // (the youngest parent of each, the first one of parents as young)
+    void resolveLineage(unsigned int genID, nAgent& a);
+    // number of generations held (from the oldest unresolved one)
+    unsigned int getDepth(void)                                 { return (unsigned int)m_generations.size(); }
+    // number of rows held (agents alive and dead)
+    unsigned int getSize(void)                                  { return m_size; }
+
+private:
+    // an agent of the ancestry
+    struct row{
+        // id of the agent and generation born in
+        unsigned int id, generation;
+        // number of direct descendants held
+        unsigned int liveDescendants;
+        // parents (rows and ids: a row is reused once dropped; noRow if none)
+        unsigned int parents[2], parentIDs[2];
+        // fitness, brain state and last move the agent died with (knockout profiles start from them)
+        double fitness;
+        unsigned long endState;
+        highState endHighState;
+        position endMove;
+        // genome (once dead, if it has descendants) in the pool of genes
+        size_t genomeOffset;
+        unsigned int genomeLength;
+        // the agent while alive (NULL once retired)
+        nAgent* agent;
+        // in use (not dropped)
+        bool held;
+        // born without parents held (a founder or an immigrant)
+        bool orphan;
+        // island, id and generation of an immigrant there
+        nAgent::origin origin;
+    };
+
+    // a generation of the ancestry
+    struct generation{
+        // rows held
+        unsigned int held;
+        // sum of their indices (the index of the last one, once down to one)
+        unsigned long heldSum;
+        // orphan rows held
+        unsigned int orphans;
+    };
+
+    static const unsigned int noRow = ~0u;
+
+    // the rows (an agent's is m_ancestryRow) and the ones dropped, to be reused
+    std::vector<row> m_rows;
+    std::vector<unsigned int> m_freeRows;
+    // generations held (m_generations[i] is generation m_firstGenID + i)
+    std::deque<generation> m_generations;
+    unsigned int m_firstGenID;
+    // number of rows held, orphan rows held
+    unsigned int m_size, m_orphans;
+    // genomes of the dead rows with descendants, and the genes of rows dropped since
+    // (compacted away when they make up half)
+    std::vector<unsigned int> m_genes;
+    size_t m_droppedGenes;
+    // LOD entry receiver
+    entryHandler m_entryHandler;
+
+    // the row of the given agent (by id), if held
+    bool isHeld(unsigned int r, unsigned int id)          { return r < m_rows.size() && m_rows[r].held && m_rows[r].id == id; }
+    // drop a row (its genome is no LOD entry)
+    void drop(unsigned int r);
+    // drop a dead row without descendants (and the ancestors this leaves so)
+    void reclaim(unsigned int r);
+    // drop the genes of dropped rows from the pool
+    void compact(void);
+    // the held parent of a row from the youngest generation (noRow if none)
+    unsigned int lineageParent(unsigned int r);
+    // the agent of a row (made again from the row once it is dead) to the entry handler
+    void handOut(unsigned int genID, unsigned int r);
+
+    // not copyable
+    nAncestry(const nAncestry&);
+    nAncestry& operator = (const nAncestry&);
+};
+
+#endif
@@ -0,0 +1,128 @@
+//
+//  nArchipelago.cpp
+//  evoNik
+//
+
+#include "nArchipelago.hpp"
+#include "nRun.hpp"
+#include "nScheduler.hpp"
+
+nArchipelago::nArchipelago(unsigned int islands, std::ostream& progress)
+: m_islands(islands),
+m_posted(islands),
+m_postedOrigins(islands),
+m_barrier(islands),
+m_progressFile(progress){
+}
+
+
+void nArchipelago::exchange(unsigned int island, nPopulation& population, std::vector<nGenome>& immigrants,
+                            std::vector<nAgent::origin>& origins){
+
+    // post copies of the fittest genomes
+    unsigned int emigrants = std::max(1u, static_cast<unsigned int>(params.migrationRate*params.populationSize + 0.5));
+    std::vector<nAgent*> fittest = population.getFittest(emigrants);
+
+    m_posted[island].clear();
+    m_postedOrigins[island].clear();
+    for (std::vector<nAgent*>::iterator it = fittest.begin(); it != fittest.end(); it++) {
+        nAgent::origin o;
+        o.island = (int)island;
+        o.id = (*it)->m_id;
+        o.generation = (*it)->m_generation;
+        m_posted[island].push_back((*it)->m_genome);
+        m_postedOrigins[island].push_back(o);
+    }
+
+    // everybody posted
+    m_barrier.wait();
+
+    // collect from the neighbours
+    immigrants.clear();
+    origins.clear();
+    if (params.migrationTopology == "ring") {
+        unsigned int source = (island + m_islands - 1) % m_islands;
+        immigrants.insert(immigrants.end(), m_posted[source].begin(), m_posted[source].end());
+        origins.insert(origins.end(), m_postedOrigins[source].begin(), m_postedOrigins[source].end());
+    }
+    else {
+        for (unsigned int source = 0; source < m_islands; source++)
+            if (source != island) {
+                immigrants.insert(immigrants.end(), m_posted[source].begin(), m_posted[source].end());
+                origins.insert(origins.end(), m_postedOrigins[source].begin(), m_postedOrigins[source].end());
+            }
+    }
+
+    // everybody collected (before anyone posts again)
+    m_barrier.wait();
+}
+
+
+void nArchipelago::report(unsigned int island, unsigned int genID, double averageFitness, double maxFitness){
+
+    boost::mutex::scoped_lock lock(m_progressMutex);
+
+    std::vector<std::pair<double, double> >& generation = m_progress[genID];
+    generation.resize(m_islands);
+    generation[island] = std::make_pair(averageFitness, maxFitness);
+
+    // wait for the slower islands
+    if (++m_reported[genID] < m_islands)
+        return;
+
+    // (generations complete in order, the slowest island reports them in order)
+    double average(0.0), max(0.0);
+    for (unsigned int i = 0; i < m_islands; i++) {
+        average += generation[i].first / m_islands;
+        max = std::max(max, generation[i].second);
+    }
+
+    m_progressFile << genID << "\t" << average << "\t" << max;
+    for (unsigned int i = 0; i < m_islands; i++)
+        m_progressFile << "\t" << generation[i].second;
+    m_progressFile << std::endl;
+
+    m_progress.erase(genID);
+    m_reported.erase(genID);
+}
+
+
+void nArchipelago::goIslands(std::string runName, unsigned int firstID, unsigned int seed, unsigned int numThreads){
+
+    // the analyses of all islands share the cores
+    nScheduler scheduler(numThreads);
+
+    std::vector<nRun*> islands;
+    for (unsigned int i = 0; i < params.islands; i++)
+        islands.push_back(new nRun(runName, firstID + i, seed + i, &scheduler));
+
+    // merged progress, next to the island directories
+    std::ostringstream fileName;
+    fileName << "islands_" << firstID << "_progressData.txt";
+    std::fstream progressFile((islands[0]->getDataDirectory()/fileName.str()).string().c_str(),
+                              std::ios::out | std::ios::app);
+
+    progressFile << "# islands " << firstID << " to " << firstID + params.islands - 1
+    << " (seeds " << seed << " to " << seed + params.islands - 1 << "), "
+    << params.migrationTopology << " migration every " << params.migrationInterval << " generations" << std::endl;
+    progressFile << "# gen \t ave. fitness\tMax. fitness\tMax. fitness per island" << std::endl;
+
+    nArchipelago archipelago(params.islands, progressFile);
+
+    if (!params.suppressMessages)
+        std::cout << "Evolving " << params.islands << " islands" << std::endl;
+
+    // one thread per island (they meet at the migrations)
+    boost::thread_group threads;
+    for (unsigned int i = 0; i < params.islands; i++) {
+        islands[i]->joinArchipelago(archipelago, i);
+        threads.create_thread(boost::bind(&nRun::go, islands[i]));
+    }
+    threads.join_all();
+
+    for (unsigned int i = 0; i < params.islands; i++) {
+        islands[i]->close();
+        delete islands[i];
+    }
+    progressFile.close();
+}
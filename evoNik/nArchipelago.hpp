@@ -0,0 +1,65 @@
+//
+//  nArchipelago.hpp
+//  evoNik
+//
+//  Island model: a number of runs (islands) evolve side by side, one
+//  thread each, and every migrationInterval generations exchange copies
+//  of their fittest genomes. The islands meet at a barrier to post
+//  emigrants, take immigrants from their neighbours (migrationTopology:
+//  ring, from the previous island, or full, from all others) and meet
+//  again before anyone posts anew. Apart from that they run freely, with
+//  their own seed, LOD, knockout and progress files; the archipelago adds
+//  a progress file over all islands.
+//
+
+#ifndef evoNik_nArchipelago_hpp
+#define evoNik_nArchipelago_hpp
+
+#include <map>
+#include <vector>
+
+#include "utility.hpp"
+#include "nGenome.hpp"
+#include "nPopulation.hpp"
+
+class nArchipelago{
+public:
+
+    // constructor with the number of islands and the merged progress stream
+    nArchipelago(unsigned int islands, std::ostream& progress);
+
+    // member functions
+    // number of islands
+    unsigned int getIslands(void)                               { return m_islands; }
+    // post the fittest of an island's (evaluated) population and collect its immigrants
+    // and where they come from (blocks until all islands posted)
+    void exchange(unsigned int island, nPopulation& population, std::vector<nGenome>& immigrants,
+                  std::vector<nAgent::origin>& origins);
+    // progress of an island in a generation (written out once all islands reported it)
+    void report(unsigned int island, unsigned int genID, double averageFitness, double maxFitness);
+
+    // evolve params.islands islands (ids firstID, firstID+1, ...) with migration
+    static void goIslands(std::string runName, unsigned int firstID, unsigned int seed, unsigned int numThreads = 0);
+
+private:
+    // number of islands
+    unsigned int m_islands;
+    // emigrant genomes posted by each island (and where they come from)
+    std::vector<std::vector<nGenome> > m_posted;
+    std::vector<std::vector<nAgent::origin> > m_postedOrigins;
+    // the islands meet here (posting, collecting)
+    boost::barrier m_barrier;
+
+    // merged progress: (average, max. fitness) per island of generations not yet complete
+    std::map<unsigned int, std::vector<std::pair<double, double> > > m_progress;
+    // islands reported per generation
+    std::map<unsigned int, unsigned int> m_reported;
+    std::ostream& m_progressFile;
+    boost::mutex m_progressMutex;
+
+    // not copyable
+    nArchipelago(const nArchipelago&);
+    nArchipelago& operator = (const nArchipelago&);
+};
+
+#endif
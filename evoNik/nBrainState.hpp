@@ -0,0 +1,202 @@
+//
+//  nBrainState.hpp
+//  evoNik
+//
+//  Short Description :
+//  Brain states wider than a word. A brain of up to stateWordBits
+//  nodes keeps its state in an unsigned long (node i as bit i); a
+//  wider one in an nBrainState, a fixed number of such words (node i
+//  as bit i%stateWordBits of word i/stateWordBits). The kernels and
+//  the analyses are written once for both, through the overloads at
+//  the end of this file; the fixed word loops of nBrainState are
+//  unrolled (and vectorized) by the compiler.
+//
+
+#ifndef evoNik_nBrainState_hpp
+#define evoNik_nBrainState_hpp
+
+#include <vector>
+#include <iomanip>
+
+#include "utility.hpp"
+
+template<unsigned int words>
+class nBrainState{
+public:
+
+    // constructor (all nodes off)
+    nBrainState(){
+        for (unsigned int i = 0; i < words; i++)
+            m_words[i] = 0;
+    }
+
+    // constructor from the nodes of the first word
+    explicit nBrainState(unsigned long low){
+        m_words[0] = low;
+        for (unsigned int i = 1; i < words; i++)
+            m_words[i] = 0;
+    }
+
+    // constructor from the first word and the rest
+    nBrainState(unsigned long low, const nBrainState<words - 1>& high){
+        m_words[0] = low;
+        for (unsigned int i = 1; i < words; i++)
+            m_words[i] = high.word(i - 1);
+    }
+
+    // member functions
+    // a word of the state
+    unsigned long word(unsigned int i) const                    { return m_words[i]; }
+    unsigned long& word(unsigned int i)                         { return m_words[i]; }
+    // the first word, and the rest
+    unsigned long low(void) const                               { return m_words[0]; }
+    nBrainState<words - 1> high(void) const{
+        nBrainState<words - 1> h;
+        for (unsigned int i = 1; i < words; i++)
+            h.word(i - 1) = m_words[i];
+        return h;
+    }
+    // a node of the state
+    bool test(unsigned int node) const                          { return (m_words[node/stateWordBits] >> (node%stateWordBits))&1; }
+    void set(unsigned int node)                                 { m_words[node/stateWordBits] |= (1UL << (node%stateWordBits)); }
+    void reset(unsigned int node)                               { m_words[node/stateWordBits] &= ~(1UL << (node%stateWordBits)); }
+    // any node on
+    bool any(void) const{
+        unsigned long on = 0;
+        for (unsigned int i = 0; i < words; i++)
+            on |= m_words[i];
+        return on != 0;
+    }
+
+    // operators (word by word)
+    nBrainState& operator &= (const nBrainState& o){
+        for (unsigned int i = 0; i < words; i++)
+            m_words[i] &= o.m_words[i];
+        return *this;
+    }
+    nBrainState& operator |= (const nBrainState& o){
+        for (unsigned int i = 0; i < words; i++)
+            m_words[i] |= o.m_words[i];
+        return *this;
+    }
+    nBrainState& operator ^= (const nBrainState& o){
+        for (unsigned int i = 0; i < words; i++)
+            m_words[i] ^= o.m_words[i];
+        return *this;
+    }
+    nBrainState operator & (const nBrainState& o) const         { nBrainState s(*this); return s &= o; }
+    nBrainState operator | (const nBrainState& o) const         { nBrainState s(*this); return s |= o; }
+    nBrainState operator ^ (const nBrainState& o) const         { nBrainState s(*this); return s ^= o; }
+    nBrainState operator ~ () const{
+        nBrainState s;
+        for (unsigned int i = 0; i < words; i++)
+            s.m_words[i] = ~m_words[i];
+        return s;
+    }
+    bool operator == (const nBrainState& o) const{
+        unsigned long differ = 0;
+        for (unsigned int i = 0; i < words; i++)
+            differ |= m_words[i] ^ o.m_words[i];
+        return differ == 0;
+    }
+    bool operator != (const nBrainState& o) const               { return !(*this == o); }
+    // (as a number, for ordered containers)
+    bool operator < (const nBrainState& o) const{
+        for (unsigned int i = words; i-- > 0; )
+            if (m_words[i] != o.m_words[i])
+                return m_words[i] < o.m_words[i];
+        return false;
+    }
+
+private:
+    // node i is bit i%stateWordBits of word i/stateWordBits
+    unsigned long m_words[words];
+};
+
+
+// brain states of brains wider than a word (see nAgent)
+typedef nBrainState<maxStateWords> wideState;
+// the nodes of a wide brain beyond the first word
+typedef nBrainState<maxStateWords - 1> highState;
+
+
+// print a state (wide ones as one hexadecimal number)
+template<unsigned int words>
+inline std::ostream& operator << (std::ostream& out, const nBrainState<words>& s){
+    std::ios_base::fmtflags flags = out.flags();
+    char fill = out.fill('0');
+    out << "0x" << std::hex;
+    for (unsigned int i = words; i-- > 0; )
+        out << std::setw(stateWordBits/4) << s.word(i);
+    out.flags(flags);
+    out.fill(fill);
+    return out;
+}
+
+
+//// the same operations on a word and on a wide state
+// a node of a state
+inline bool stateBit(unsigned long state, unsigned int node){
+    return (state >> node)&1;
+}
+
+template<unsigned int words>
+inline bool stateBit(const nBrainState<words>& state, unsigned int node){
+    return state.test(node);
+}
+
+// set a node of a state
+inline void setNode(unsigned long& state, unsigned int node){
+    state |= (1UL << node);
+}
+
+template<unsigned int words>
+inline void setNode(nBrainState<words>& state, unsigned int node){
+    state.set(node);
+}
+
+template<unsigned int words>
+inline void applyMask(nBrainState<words>& state, int bitPosition, bool zeroOrOne){
+    // no node masked
+    if (bitPosition < 0)
+        return;
+    if (zeroOrOne)
+        state.set(bitPosition);
+    else
+        state.reset(bitPosition);
+}
+
+// the given nodes of a state (node nodes[i] as bit i; at most a word of them)
+template<unsigned int words>
+inline unsigned long projectState(const nBrainState<words>& state, const std::vector<size_t>& nodes){
+    unsigned long projected = 0;
+    for (size_t i = 0; i < nodes.size(); i++)
+        projected |= (unsigned long)state.test((unsigned int)nodes[i]) << i;
+    return projected;
+}
+
+// append the words of a state (to a phenotype)
+inline void appendState(std::vector<unsigned long>& words, unsigned long state){
+    words.push_back(state);
+}
+
+template<unsigned int words>
+inline void appendState(std::vector<unsigned long>& stateWords, const nBrainState<words>& state){
+    for (unsigned int i = 0; i < words; i++)
+        stateWords.push_back(state.word(i));
+}
+
+// the first nodes of a state, as a bit string
+inline binary toBinary(unsigned long state, size_t nodes){
+    return binary(nodes, state);
+}
+
+template<unsigned int words>
+inline binary toBinary(const nBrainState<words>& state, size_t nodes){
+    binary b(nodes);
+    for (size_t node = 0; node < nodes; node++)
+        b[node] = state.test((unsigned int)node);
+    return b;
+}
+
+#endif
@@ -0,0 +1,34 @@
+//
+//  nFitnessCache.cpp
+//  evoNik
+//
+
+#include "nFitnessCache.hpp"
+
+const nFitnessCache::evaluation* nFitnessCache::find(const std::vector<unsigned long>& phenotype, unsigned int mazeID){
+
+    m_lookups++;
+
+    // evaluations in another maze are worthless
+    if (mazeID != m_mazeID)
+        return NULL;
+
+    boost::unordered_map<std::vector<unsigned long>, evaluation, boost::hash<std::vector<unsigned long> > >::const_iterator it = m_evaluations.find(phenotype);
+    if (it == m_evaluations.end())
+        return NULL;
+
+    m_hits++;
+    return &it->second;
+}
+
+
+void nFitnessCache::insert(const std::vector<unsigned long>& phenotype, unsigned int mazeID, const evaluation& e){
+
+    // a new maze
+    if (mazeID != m_mazeID) {
+        m_evaluations.clear();
+        m_mazeID = mazeID;
+    }
+
+    m_evaluations[phenotype] = e;
+}
@@ -0,0 +1,66 @@
+//
+//  nFitnessCache.hpp
+//  evoNik
+//
+//  Fitness evaluations of deterministic brains, keyed by their
+//  phenotype (the compiled HMM units, see nAgent::getPhenotype) in a
+//  given maze. Agents with different genomes but the same brain (most
+//  mutations are silent) share one evaluation. A new maze plan
+//  invalidates everything.
+//
+
+#ifndef evoNik_nFitnessCache_hpp
+#define evoNik_nFitnessCache_hpp
+
+#include <vector>
+
+#include <boost/unordered_map.hpp>
+
+#include "utility.hpp"
+#include "nBrainState.hpp"
+
+class nFitnessCache{
+public:
+
+    // outcome of the evaluation of a fresh agent
+    struct evaluation{
+        // fitness and number of games it averages
+        double fitness;
+        unsigned int fitnessEvalCount;
+        // brain state and last move after the games
+        unsigned long endState;
+        highState endHighState;
+        position endMove;
+    };
+
+    // constructor
+    nFitnessCache()
+    : m_mazeID(0),
+    m_lookups(0),
+    m_hits(0){
+    }
+
+    // member functions
+    // evaluation of a phenotype in a maze (NULL if not known)
+    const evaluation* find(const std::vector<unsigned long>& phenotype, unsigned int mazeID);
+    // store the evaluation of a phenotype in a maze
+    void insert(const std::vector<unsigned long>& phenotype, unsigned int mazeID, const evaluation& e);
+    // forget everything
+    void clear(void)                                            { m_evaluations.clear(); }
+    // fraction of lookups found since the last reset
+    double getHitRate(void)                                     { return (m_lookups == 0) ? 0 : (double)m_hits / m_lookups; }
+    // lookups and hits since the last reset
+    unsigned long getLookups(void)                              { return m_lookups; }
+    unsigned long getHits(void)                                 { return m_hits; }
+    // reset the hit rate
+    void resetHitRate(void)                                     { m_lookups = m_hits = 0; }
+
+private:
+    // evaluations (in maze m_mazeID)
+    boost::unordered_map<std::vector<unsigned long>, evaluation, boost::hash<std::vector<unsigned long> > > m_evaluations;
+    unsigned int m_mazeID;
+    // hit statistics
+    unsigned long m_lookups, m_hits;
+};
+
+#endif
@@ -20,7 +20,105 @@ void nGame::updatePlayGround(nMaze& maze){
 }
 
 
-void nGame::execute(unsigned int lapTime){
+unsigned int nGame::evaluate(nAgent& a){
+    
+    updatePlayer(a);
+    
+    // with deterministic units and no food, a game is fixed by the brain
+    // state (and, under gravity, the last move) the player starts it with
+    if (params.deterministicHMM && !params.huntForFood)
+        return evaluateCached(a);
+    
+    // evaluate a number of times to reduce evaluation error
+    for (unsigned int i = 0; i < params.evaluationRepetition; i++)
+        execute();
+    return params.evaluationRepetition;
+}
+
+
+unsigned int nGame::evaluateCached(nAgent& a){
+    
+    // only fresh agents (fitness and brain as born) share evaluations
+    bool fresh = a.m_fitnessEvalCount == 0 && a.m_curState == 0 && !a.m_curHighState.any() &&
+    (!params.gravityPresent || (a.m_prevPosition.x == 0 && a.m_prevPosition.y == 0));
+    
+    std::vector<unsigned long> phenotype;
+    if (m_fitnessCache == NULL || !fresh || !a.getPhenotype(phenotype))
+        return evaluateDeterministic(a);
+    
+    unsigned int mazeID = m_playGround->getID();
+    
+    // the same brain was evaluated in this maze already
+    const nFitnessCache::evaluation* known = m_fitnessCache->find(phenotype, mazeID);
+    if (known != NULL) {
+        a.m_fitness = known->fitness;
+        a.m_fitnessEvalCount = known->fitnessEvalCount;
+        a.m_curState = known->endState;
+        a.m_curHighState = known->endHighState;
+        a.m_prevPosition = known->endMove;
+        return 0;
+    }
+    
+    unsigned int gamesPlayed = evaluateDeterministic(a);
+    
+    nFitnessCache::evaluation e;
+    e.fitness = a.m_fitness;
+    e.fitnessEvalCount = a.m_fitnessEvalCount;
+    e.endState = a.m_curState;
+    e.endHighState = a.m_curHighState;
+    e.endMove = a.m_prevPosition;
+    m_fitnessCache->insert(phenotype, mazeID, e);
+    
+    return gamesPlayed;
+}
+
+
+unsigned int nGame::evaluateDeterministic(nAgent& a){
+    
+    // the games played so far (by their starting conditions)
+    struct game{
+        unsigned long startState, endState;
+        highState startHighState, endHighState;
+        position startMove, endMove;
+        double score;
+    };
+    std::vector<game> games;
+    games.reserve(params.evaluationRepetition);
+    
+    for (unsigned int i = 0; i < params.evaluationRepetition; i++) {
+        
+        // a repetition starting as an earlier one: the rest cycles through those
+        for (size_t c = 0; c < games.size(); c++)
+            if (games[c].startState == a.m_curState && games[c].startHighState == a.m_curHighState &&
+                (!params.gravityPresent || (games[c].startMove.x == a.m_prevPosition.x &&
+                                            games[c].startMove.y == a.m_prevPosition.y))) {
+                size_t cycle = games.size() - c;
+                for (unsigned int j = 0; i + j < params.evaluationRepetition; j++) {
+                    const game& g = games[c + j % cycle];
+                    a.updateFitness(g.score, params.useGeometricMean);
+                    a.m_curState = g.endState;
+                    a.m_curHighState = g.endHighState;
+                    a.m_prevPosition = g.endMove;
+                }
+                return (unsigned int)games.size();
+            }
+        
+        game g;
+        g.startState = a.m_curState;
+        g.startHighState = a.m_curHighState;
+        g.startMove = a.m_prevPosition;
+        g.score = execute();
+        g.endState = a.m_curState;
+        g.endHighState = a.m_curHighState;
+        g.endMove = a.m_prevPosition;
+        games.push_back(g);
+    }
+    
+    return (unsigned int)games.size();
+}
+
+
+double nGame::execute(unsigned int lapTime){
     
     // confirm a valid maze
     if (!m_playGround->isValid()){
@@ -35,16 +133,20 @@ void nGame::execute(unsigned int lapTime){
     }
         
     // if food is required and the agent is not a solver 
-    if (huntForFood &&
+    if (params.huntForFood &&
         m_player->m_id != 1234567890){
         // adjust the lap time with deficit
-        lapTime = static_cast<unsigned int>(lapTime*(1.0 - agentDeficit));
+        lapTime = static_cast<unsigned int>(lapTime*(1.0 - params.agentDeficit));
         // replenish the food in the maze
-        m_playGround->replanishFood();
+        replanishFood();
     }
     
+    // (the playGround may have changed since the last game)
+    m_nearChunks[0].reset();
+    m_nearChunks[1].reset();
+    
     // place the player in the maze (in front of the first door)
-    m_player->m_position = position(0, (m_playGround->getDoors())[0].y);
+    m_player->m_position = position(0, m_playGround->getEntry().y);
     // update history
     m_player->m_trajectory.push_back(m_player->m_position);
     
@@ -53,45 +155,95 @@ void nGame::execute(unsigned int lapTime){
     // fitness for this test
     double fitness(0.0);
     unsigned int completedLaps(0);
+    // brain updates (for the run profile)
+    unsigned long brainSteps(0);
+    
+    // a deterministic game (no food to change the maze) that returns to an
+    // earlier state repeats itself from there on: find such a cycle with
+    // Brent's algorithm (compare to a checkpoint moved at powers of two)
+    bool detectCycles = m_player->isDeterministic() &&
+    !(params.huntForFood && m_player->m_id != 1234567890);
+    gameState checkpoint = gameState();
+    unsigned int step(0), checkpointStep(0), checkpointTime(0), checkpointLaps(0), power(1);
     
     while (timeStep++ < lapTime) {
                 
         // if the agent is alive
         if (m_player->m_alive){
+            
+            // the state this step starts from
+            gameState current;
+            current.brainState = m_player->m_curState;
+            current.brainHighState = m_player->m_curHighState;
+            current.pos = m_player->m_position;
+            current.prevPos = m_player->m_prevPosition;
+            current.fitness = fitness;
                 
             // current state becomes previous state
             m_player->m_prevState = m_player->m_curState;
+            m_player->m_prevHighState = m_player->m_curHighState;
             
             // make it fresh-minded
             m_player->m_curState = 0;
+            m_player->m_curHighState = highState();
             
             // expose the local ground
             exposePlayGround();
             
             // update brain state, if environmental update is included
-            if (includeEnvUpdate && !m_player->m_stateHistory.empty()) 
+            if (params.includeEnvUpdate && !m_player->m_stateHistory.empty()) {
                 m_player->m_stateHistory.back().second = m_player->m_prevState;
+                if (!m_player->m_wideStateHistory.empty())
+                    m_player->m_wideStateHistory.back().second = wideState(m_player->m_prevState, m_player->m_prevHighState);
+            }
+            
+            // the history of the steps so far is complete now
+            if (detectCycles) {
+                if (step > 0 && current == checkpoint) {
+                    // skip all whole cycles that start in time
+                    unsigned int cycleTime = timeStep - 1 - checkpointTime;
+                    unsigned int cycles = (lapTime - timeStep)/cycleTime;
+                    
+                    repeatHistory(step - checkpointStep, cycles);
+                    completedLaps += cycles*(completedLaps - checkpointLaps);
+                    timeStep += cycles*cycleTime;
+                    PROFILE_COUNT(COUNT_SKIPPED_STEPS, (unsigned long)cycles*(step - checkpointStep));
+                    
+                    detectCycles = false;
+                }
+                else if (step == checkpointStep + power || step == 0) {
+                    // move the checkpoint here
+                    checkpoint = current;
+                    checkpointStep = step;
+                    checkpointTime = timeStep - 1;
+                    checkpointLaps = completedLaps;
+                    if (step > 0)
+                        power *= 2;
+                }
+                step++;
+            }
                 
             // let the player decide action
             m_player->updateBrain();
+            brainSteps++;
     
             // should I eat any food?
-            if (huntForFood && m_player->m_id != 1234567890) {
+            if (params.huntForFood && m_player->m_id != 1234567890) {
                 // if mouth (bit # 9) is open and if the food was not already consumed
                 if (((m_player->m_curState >> 9)&1) && 
-                    !((m_playGround->getFloorPlan()[m_player->m_position.x][m_player->m_position.y] >> 3)&1)) {
+                    !foodEaten(m_player->m_position)) {
                     // if food is healthy
-                    if (((m_playGround->getFloorPlan()[m_player->m_position.x][m_player->m_position.y] >> 2)&1) ) {
+                    if (((cell(m_player->m_position.x, m_player->m_position.y) >> 2)&1) ) {
                         lapTime += 2; 
                         // keep lapTime lower than (maximum) evaluation time
-                        if (lapTime > evaluationTime)
-                            lapTime = evaluationTime;
+                        if (lapTime > params.evaluationTime)
+                            lapTime = params.evaluationTime;
                     }                    
                     else // food is poisonous
                         lapTime = (unsigned int)std::max((int)lapTime - 4, 0);
                                         
                     // make the food consumed
-                    applyBit(m_playGround->getFloorPlan()[m_player->m_position.x][m_player->m_position.y], 3, 1);
+                    eatFood(m_player->m_position);
                 }
             }
             
@@ -99,13 +251,13 @@ void nGame::execute(unsigned int lapTime){
             movePlayer();
             
             // if agent moved aginst gravity penalize
-            if (gravityPresent &&
+            if (params.gravityPresent &&
                 m_player->m_prevPosition.y > m_player->m_position.y)
                 timeStep++;
             
             // update the fitness of the player
             if (m_player->m_id != 1234567890)    // for solver don't worry about fitness
-                fitness = m_playGround->getFitnessLandscape()[m_player->m_position.x][m_player->m_position.y];
+                fitness = chunkAt(m_player->m_position.x).getFitness(m_player->m_position.x, m_player->m_position.y);
             
             // if it reached the goal
             if (fitness == 1) {
@@ -114,7 +266,7 @@ void nGame::execute(unsigned int lapTime){
                 // reset fitness
                 fitness = 0;
                 // place the agent at the maze entry again
-                m_player->m_position = position(0, (m_playGround->getDoors())[0].y);
+                m_player->m_position = position(0, m_playGround->getEntry().y);
             }
             
         }
@@ -122,13 +274,38 @@ void nGame::execute(unsigned int lapTime){
     }
     
     // update the fitness for "this" agent
-    m_player->updateFitness(fitness + completedLaps, useGeometricMean);
+    m_player->updateFitness(fitness + completedLaps, params.useGeometricMean);
     
     // replanish food (for next execution)
-    m_playGround->replanishFood();
+    replanishFood();
+    
+    PROFILE_COUNT(COUNT_BRAIN_STEPS, brainSteps);
+    
+    return fitness + completedLaps;
+}
+
+// repeat the last period entries of a history
+template<typename T>
+static void repeatTail(std::vector<T>& history, size_t period, unsigned int cycles){
+    size_t first = history.size() - period;
+    history.reserve(history.size() + cycles*period);
+    for (unsigned int cycle = 0; cycle < cycles; cycle++)
+        for (size_t i = 0; i < period; i++)
+            history.push_back(history[first + i]);
+}
+
+void nGame::repeatHistory(size_t period, unsigned int cycles){
+    
+    // brain states (and the whole ones of a wide brain)
+    repeatTail(m_player->m_stateHistory, period, cycles);
+    if (!m_player->m_wideStateHistory.empty())
+        repeatTail(m_player->m_wideStateHistory, period, cycles);
     
+    // trajectory
+    repeatTail(m_player->m_trajectory, period, cycles);
 }
 
+
 void nGame::exposePlayGround(){
     
 //    // bit 0 : front retina
@@ -177,42 +354,42 @@ void nGame::exposePlayGround(){
     // expose the local play ground to the player
     // bit 0 : retina
     applyBit(m_player->m_curState, 0, 
-             (m_playGround->getFloorPlan())[m_player->m_position.x + 1][m_player->m_position.y]&1);
+             cell(m_player->m_position.x + 1, m_player->m_position.y)&1);
     applyBit(m_player->m_prevState, 0, 
-             (m_playGround->getFloorPlan())[m_player->m_position.x + 1][m_player->m_position.y]&1);
+             cell(m_player->m_position.x + 1, m_player->m_position.y)&1);
     
     // bit 1 : left collision sensor
     applyBit(m_player->m_curState, 1, 
-             (m_playGround->getFloorPlan())[m_player->m_position.x][m_player->m_position.y - 1]&1);
+             cell(m_player->m_position.x, m_player->m_position.y - 1)&1);
     applyBit(m_player->m_prevState, 1, 
-             (m_playGround->getFloorPlan())[m_player->m_position.x][m_player->m_position.y - 1]&1);
+             cell(m_player->m_position.x, m_player->m_position.y - 1)&1);
  
     // bit 2 : right collision sensor
     applyBit(m_player->m_curState, 2, 
-             (m_playGround->getFloorPlan())[m_player->m_position.x][m_player->m_position.y + 1]&1);
+             cell(m_player->m_position.x, m_player->m_position.y + 1)&1);
     applyBit(m_player->m_prevState, 2, 
-             (m_playGround->getFloorPlan())[m_player->m_position.x][m_player->m_position.y + 1]&1);
+             cell(m_player->m_position.x, m_player->m_position.y + 1)&1);
     
     // bit 3 : door sensor
     applyBit(m_player->m_curState, 3, 
-             ((m_playGround->getFloorPlan())[m_player->m_position.x][m_player->m_position.y]>>1)&1);
+             (cell(m_player->m_position.x, m_player->m_position.y)>>1)&1);
     applyBit(m_player->m_prevState, 3, 
-             ((m_playGround->getFloorPlan())[m_player->m_position.x][m_player->m_position.y]>>1)&1);
+             (cell(m_player->m_position.x, m_player->m_position.y)>>1)&1);
     
     // bit 4 : food smell sensor
     applyBit(m_player->m_curState, 4, 0);
     applyBit(m_player->m_prevState, 4, 0);
-    if (huntForFood) {
+    if (params.huntForFood) {
         applyBit(m_player->m_curState, 4, 
-                 ((m_playGround->getFloorPlan())[m_player->m_position.x][m_player->m_position.y]>>2)&1);
+                 (cell(m_player->m_position.x, m_player->m_position.y)>>2)&1);
         applyBit(m_player->m_prevState, 4, 
-                 ((m_playGround->getFloorPlan())[m_player->m_position.x][m_player->m_position.y]>>2)&1);
+                 (cell(m_player->m_position.x, m_player->m_position.y)>>2)&1);
     }        
     
     // bit 5 : gravity pull sensor
     applyBit(m_player->m_curState, 5, 0);
     applyBit(m_player->m_prevState, 5, 0);
-    if (gravityPresent) {
+    if (params.gravityPresent) {
         // if the player moved against gravity
         if (m_player->m_prevPosition.y > m_player->m_position.y){
             applyBit(m_player->m_curState, 5, 1);
@@ -246,7 +423,7 @@ void nGame::movePlayer(){
     
     // check if the player sits on top of a wall
     // if so, take it back to previous position
-    if ((m_playGround->getFloorPlan())[m_player->m_position.x][m_player->m_position.y] == 1)
+    if (cell(m_player->m_position.x, m_player->m_position.y) == 1)
         m_player->m_position = m_player->m_prevPosition;
     
     // update the trajectory
@@ -281,10 +458,15 @@ void nGame::printGame(std::ostream& output){
     output << "timeStep\tbrainPre\tbrainCur\txPos\tyPos" << std::endl;
     
     for (size_t i = 0; i < size; i++) {
-        output << i << "\t"
-        << m_player->m_stateHistory[i].first << "\t"
-        << m_player->m_stateHistory[i].second << "\t"
-        << m_player->m_trajectory[i].x << "\t"
+        output << i << "\t";
+        // (the whole states of a wide brain)
+        if (nAgent::wideBrain())
+            output << m_player->m_wideStateHistory[i].first << "\t"
+            << m_player->m_wideStateHistory[i].second << "\t";
+        else
+            output << m_player->m_stateHistory[i].first << "\t"
+            << m_player->m_stateHistory[i].second << "\t";
+        output << m_player->m_trajectory[i].x << "\t"
         << m_player->m_trajectory[i].y << std::endl;
     }
     
@@ -302,7 +484,7 @@ void nGame::profilePlayerKnockout(){
     std::vector<double> KOfitnesses;
     
     // for each node
-    for (unsigned int node = 0; node < maxNodes; node++) {
+    for (unsigned int node = 0; node < params.maxNodes; node++) {
         
         // for each possible bit value
         for (int i = 0; i < 2; i++) {
@@ -336,9 +518,6 @@ void nGame::constructFitnessLandscape(){
         std::cerr << "Error in nGame: not a valid playGround!\n" 
         << "can not construct fitness landscape" << std::endl;
     
-    // erase previous fitness landscape
-    m_playGround->getFitnessLandscape().clear();
-    
     // set a reasonable goal in the maze
     // (reach of "Einstein")
     
@@ -414,7 +593,7 @@ void nGame::constructFitnessLandscape(){
     // send solver into the maze
     updatePlayer(solver);
     
-    if (!suppressMessages)
+    if (!params.suppressMessages)
         std::cout << "Solver is solving the maze" << std::endl;
    
     // make him solve
@@ -423,18 +602,14 @@ void nGame::constructFitnessLandscape(){
     // that's the goal
     position goal = m_player->m_position;
     
-    // construct fitness landscape
-    nDijkstra dijk;
-    dijk.buildGraph(m_playGround->getFloorPlan(), false);
-    dijk.computeFitnessArray(m_playGround->getFitnessLandscape(),
-                             goal.x, 
-                             goal.y);
+    // construct fitness landscape (distances to the goal)
+    m_playGround->setGoal(goal);
     
-    if (!suppressMessages)
+    if (!params.suppressMessages)
         std::cout << "Done solving! Updated fitness landscape" << std::endl;
     
     // if food is required
-    if (huntForFood)
+    if (params.huntForFood)
         m_playGround->sprinkleFood();    
 
     
@@ -14,6 +14,7 @@
 #include "utility.hpp"
 #include "nMaze.hpp"
 #include "nAgent.hpp"
+#include "nFitnessCache.hpp"
 
 class nGame{
 public:
@@ -23,17 +24,19 @@ public:
     
     // constructor with only a maze
     nGame(nMaze& maze)
-    :m_playGround(&maze),        
-    m_knockoutOutput(&std::cout){
+    :m_knockoutOutput(&std::cout),
+    m_playGround(&maze),
+    m_fitnessCache(NULL){
         constructFitnessLandscape();
         
     }
     
     // constructor
     nGame(nAgent& player, nMaze& playGround): 
+    m_knockoutOutput(&std::cout),
     m_player(&player), 
     m_playGround(&playGround),
-    m_knockoutOutput(&std::cout){
+    m_fitnessCache(NULL){
         constructFitnessLandscape();
     }
         
@@ -53,10 +56,15 @@ public:
     void updatePlayer(nAgent& a)                      { m_player = &a; }
     // update playGround
     void updatePlayGround(nMaze& maze);
+    // play in a playGround whose fitness landscape is laid already (one maze is
+    // shared by any number of concurrent games)
+    void usePlayGround(nMaze& maze)                   { m_playGround = &maze; }
     // lay fitness landscape
     void constructFitnessLandscape(void);
-    // execute the game
-    void execute(unsigned int lapTime = evaluationTime);
+    // evaluate a player (evaluationRepetition games; returns the games actually played)
+    unsigned int evaluate(nAgent& a);
+    // execute the game (returns the score of this game, also added to the player's fitness)
+    double execute(unsigned int lapTime = params.evaluationTime);
     // dump the game data (brain, trajectory etc)
     void printGame(std::ostream& output = std::cout);
     // expose local playGround to the player
@@ -67,10 +75,72 @@ public:
     void profilePlayerKnockout();
     // set player knockout output stream
     void setKnockoutStream(std::ostream& output)       { m_knockoutOutput = &output; }
+    // set the cache of (deterministic) evaluations in this game
+    void setFitnessCache(nFitnessCache& cache)         { m_fitnessCache = &cache; }
+    // get the cache of evaluations (NULL if none)
+    nFitnessCache* getFitnessCache(void)               { return m_fitnessCache; }
     
 private:
     nAgent* m_player;
     nMaze* m_playGround;
+    // evaluations (of fresh agents) in this game
+    nFitnessCache* m_fitnessCache;
+    // the chunks of the playGround used last (most recent first; reading them takes no lock)
+    nMaze::chunkPtr m_nearChunks[2];
+    // cells whose food was eaten in this game, sorted (the plan is not changed;
+    // a game eats at most once a step, whatever the size of the maze)
+    std::vector<unsigned long> m_foodEaten;
+    
+    // what the rest of a deterministic game depends on
+    struct gameState{
+        unsigned long brainState;
+        highState brainHighState;
+        position pos, prevPos;
+        double fitness;
+        
+        bool operator == (const gameState& o) const{
+            return brainState == o.brainState && brainHighState == o.brainHighState && fitness == o.fitness &&
+            pos.x == o.pos.x && pos.y == o.pos.y && prevPos.x == o.prevPos.x && prevPos.y == o.prevPos.y;
+        }
+    };
+    
+    // the chunk of the playGround holding a column
+    const nMaze::chunk& chunkAt(unsigned int x){
+        if (!m_nearChunks[0] || !m_nearChunks[0]->covers(x)) {
+            if (m_nearChunks[1] && m_nearChunks[1]->covers(x))
+                m_nearChunks[0].swap(m_nearChunks[1]);
+            else {
+                m_nearChunks[1] = m_nearChunks[0];
+                m_nearChunks[0] = m_playGround->getChunk(x);
+            }
+        }
+        return *m_nearChunks[0];
+    }
+    // floor plan at a position
+    unsigned int cell(unsigned int x, unsigned int y)  { return chunkAt(x).cell(x, y); }
+    // cell of a position in the eaten food
+    unsigned long foodCell(const position& p)         { return (unsigned long)p.x*m_playGround->getY() + p.y; }
+    // has the food at a position been eaten (in this game)
+    bool foodEaten(const position& p){
+        return std::binary_search(m_foodEaten.begin(), m_foodEaten.end(), foodCell(p));
+    }
+    // eat the food at a position
+    void eatFood(const position& p){
+        unsigned long cell = foodCell(p);
+        std::vector<unsigned long>::iterator it = std::lower_bound(m_foodEaten.begin(), m_foodEaten.end(), cell);
+        if (it == m_foodEaten.end() || *it != cell)
+            m_foodEaten.insert(it, cell);
+    }
+    // replanish all food (for the next game)
+    void replanishFood(void)                          { m_foodEaten.clear(); }
+
+    // evaluate (deterministic games) skipping repetitions known to replay an earlier game
+    unsigned int evaluateDeterministic(nAgent& a);
+    // evaluate (deterministic games) reusing the evaluation of the same brain, if known
+    unsigned int evaluateCached(nAgent& a);
+
+    // append the last period steps of the player's history cycles more times
+    void repeatHistory(size_t period, unsigned int cycles);
 
     
 };
@@ -11,7 +11,7 @@
 #include "nGenome.hpp"
 
 
-unsigned int nGenome::getGene(unsigned int position){
+unsigned int nGenome::getGene(unsigned int position) const{
     return m_genome[position % m_genome.size()];
 }
 
@@ -31,6 +31,16 @@ bool nGenome::insertGene(unsigned int g, unsigned int position){
     return true;
 }
 
+void nGenome::inherit(const nGenome& parent, size_t room){
+    // (a single allocation, kept as long as the insertions fit)
+    if (m_genome.capacity() < parent.m_genome.size() + room) {
+        std::vector<unsigned int> genes;
+        genes.reserve(parent.m_genome.size() + room);
+        m_genome.swap(genes);
+    }
+    m_genome.assign(parent.m_genome.begin(), parent.m_genome.end());
+}
+
 void nGenome::printGenome(std::ostream& fout){
     for(std::vector<unsigned int>::iterator it = m_genome.begin(); 
         it != m_genome.end(); it++)
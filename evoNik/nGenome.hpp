@@ -10,6 +10,7 @@
 #define evoNik_nGenome_hpp
 
 #include <vector>
+#include <utility>
 
 #include "utility.hpp"
 
@@ -26,12 +27,22 @@ public:
     nGenome( const nGenome& o): m_genome(o.m_genome){
     }
     
+    // move constructor (takes over the genes)
+    nGenome(nGenome&& o): m_genome(std::move(o.m_genome)){
+    }
+    
     // assignment operator
     nGenome& operator = (const nGenome& o){
         m_genome = o.m_genome;
         return *this;
     }
     
+    // move assignment operator
+    nGenome& operator = (nGenome&& o){
+        m_genome.swap(o.m_genome);
+        return *this;
+    }
+    
     // destructor
     ~nGenome(){
         m_genome.clear();
@@ -42,15 +53,17 @@ public:
     // set size (resize) of the genome
     void setSize(size_t s)               { m_genome.resize(s); }
     // get the size of the genome
-    size_t getSize(void)                 { return m_genome.size(); }
+    size_t getSize(void) const           { return m_genome.size(); }
     // get the value (gene) at the location
-    unsigned int getGene(unsigned int);
+    unsigned int getGene(unsigned int) const;
     // set the value (gene) at the location
     bool setGene(unsigned int, unsigned int);
     // delete the gene at the location
     bool deleteGene(unsigned int);
     // insert a gene at the location
     bool insertGene(unsigned int, unsigned int);
+    // copy the genes of a parent (with room for as many more, for insertions)
+    void inherit(const nGenome& parent, size_t room = 0);
     // print out genome
     void printGenome(std::ostream& fout = std::cout);
 
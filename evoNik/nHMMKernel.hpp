@@ -0,0 +1,184 @@
+//
+//  nHMMKernel.hpp
+//  evoNik
+//
+//  Short Description :
+//  HMM units compiled for firing. An nHMMUnit keeps the transition
+//  table as read from the genome; its kernel keeps only what the
+//  brain needs at every time step:
+//  - deterministic: one output code per input row
+//  - stochastic: per row alias tables (one random draw per firing)
+//  on a one word brain state, or on a wide one (see nBrainState)
+//
+
+#ifndef evoNik_nHMMKernel_hpp
+#define evoNik_nHMMKernel_hpp
+
+#include <vector>
+
+#include "utility.hpp"
+#include "nBrainState.hpp"
+#include "nHMMUnit.hpp"
+
+template<bool deterministic, typename State = unsigned long>
+class nHMMKernel;
+
+
+// common part: input row extraction and output placement
+template<typename State>
+class nHMMKernelBase{
+public:
+
+    // constructor from a (genome decoded) HMM unit
+    nHMMKernelBase(const nHMMUnit& unit)
+    : m_inputs(unit.m_inputs),
+    m_outputMask(){
+
+        size_t numOutputs = unit.m_outputs.size();
+
+        // output bits of every output code, placed on the output nodes
+        m_outputCodes.resize((size_t)1 << numOutputs, State());
+        for (size_t j = 0; j < m_outputCodes.size(); j++)
+            for (size_t i = 0; i < numOutputs; i++)
+                if ((j >> i)&1)
+                    setNode(m_outputCodes[j], unit.m_outputs[i]);
+
+        for (size_t i = 0; i < numOutputs; i++)
+            setNode(m_outputMask, unit.m_outputs[i]);
+    }
+
+protected:
+    // input nodes (the first one is the most significant bit of the row)
+    std::vector<unsigned int> m_inputs;
+    // output nodes of the unit
+    State m_outputMask;
+    // output code (column) -> state bits on the output nodes
+    std::vector<State> m_outputCodes;
+
+    // row of the transition table addressed by the given state
+    unsigned int row(const State& state) const{
+        unsigned int inputState = 0;
+        for (size_t i = 0; i < m_inputs.size(); i++)
+            inputState = (inputState << 1) | stateBit(state, m_inputs[i]);
+        return inputState;
+    }
+
+    // write an output code on the output nodes of a state
+    State place(const State& state, unsigned int code) const{
+        return (state & ~m_outputMask) | m_outputCodes[code];
+    }
+};
+
+
+// deterministic unit: every input row has a single (winner) output
+template<typename State>
+class nHMMKernel<true, State> : public nHMMKernelBase<State>{
+    using nHMMKernelBase<State>::m_inputs;
+    using nHMMKernelBase<State>::m_outputMask;
+    using nHMMKernelBase<State>::m_outputCodes;
+    using nHMMKernelBase<State>::row;
+public:
+
+    // constructor
+    nHMMKernel(const nHMMUnit& unit)
+    : nHMMKernelBase<State>(unit){
+        m_codes.resize(unit.m_hmm.size());
+        for (size_t r = 0; r < unit.m_hmm.size(); r++)
+            m_codes[r] = m_outputCodes[std::max_element(unit.m_hmm[r].begin(), unit.m_hmm[r].end()) - unit.m_hmm[r].begin()];
+    }
+
+    // fire the unit on inState, write its outputs over it into outState
+    void fire(const State& inState, State& outState) const{
+        outState = (inState & ~m_outputMask) | m_codes[row(inState)];
+    }
+
+    // append what the unit does (inputs, outputs, output per row) to a phenotype
+    void appendPhenotype(std::vector<unsigned long>& phenotype) const{
+        phenotype.push_back(m_inputs.size());
+        phenotype.insert(phenotype.end(), m_inputs.begin(), m_inputs.end());
+        appendState(phenotype, m_outputMask);
+        for (size_t r = 0; r < m_codes.size(); r++)
+            appendState(phenotype, m_codes[r]);
+    }
+
+private:
+    // input row -> output bits (placed on the output nodes)
+    std::vector<State> m_codes;
+};
+
+
+// stochastic unit: every input row is sampled from its alias table
+template<typename State>
+class nHMMKernel<false, State> : public nHMMKernelBase<State>{
+    using nHMMKernelBase<State>::m_outputCodes;
+    using nHMMKernelBase<State>::row;
+    using nHMMKernelBase<State>::place;
+public:
+
+    // constructor
+    nHMMKernel(const nHMMUnit& unit)
+    : nHMMKernelBase<State>(unit),
+    m_columns((unsigned int)m_outputCodes.size()){
+
+        m_probability.resize(unit.m_hmm.size()*m_columns);
+        m_alias.resize(unit.m_hmm.size()*m_columns);
+
+        // Vose's alias method, row by row
+        std::vector<double> scaled(m_columns);
+        std::vector<unsigned int> small, large;
+
+        for (size_t r = 0; r < unit.m_hmm.size(); r++) {
+            double* probability = &m_probability[r*m_columns];
+            unsigned int* alias = &m_alias[r*m_columns];
+
+            small.clear();
+            large.clear();
+            for (unsigned int c = 0; c < m_columns; c++) {
+                scaled[c] = (double)unit.m_hmm[r][c] * m_columns / unit.m_sums[r];
+                alias[c] = c;
+                (scaled[c] < 1.0) ? small.push_back(c) : large.push_back(c);
+            }
+
+            while (!small.empty() && !large.empty()) {
+                unsigned int s = small.back(), l = large.back();
+                small.pop_back();
+
+                probability[s] = scaled[s];
+                alias[s] = l;
+
+                scaled[l] -= 1.0 - scaled[s];
+                if (scaled[l] < 1.0) {
+                    large.pop_back();
+                    small.push_back(l);
+                }
+            }
+
+            // the rest (up to round-off) always keeps its own column
+            for (size_t i = 0; i < large.size(); i++)
+                probability[large[i]] = 1.0;
+            for (size_t i = 0; i < small.size(); i++)
+                probability[small[i]] = 1.0;
+        }
+    }
+
+    // fire the unit on inState, write its outputs over it into outState
+    void fire(const State& inState, State& outState) const{
+
+        // one draw: the integer part picks a column, the fraction accepts it or its alias
+        double u = genUniRand(0, m_columns);
+        unsigned int column = std::min((unsigned int)u, m_columns - 1);
+        size_t k = row(inState)*m_columns + column;
+
+        outState = place(inState, (u - column < m_probability[k]) ? column : m_alias[k]);
+    }
+
+private:
+    // number of output codes (columns of the table)
+    unsigned int m_columns;
+    // alias tables (row major)
+    std::vector<double> m_probability;
+    std::vector<unsigned int> m_alias;
+};
+
+
+#endif
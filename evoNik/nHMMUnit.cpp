@@ -8,7 +8,7 @@
 
 #include "nHMMUnit.hpp"
 
-void nHMMUnit::setup(nGenome genome, unsigned int start){
+void nHMMUnit::setup(const nGenome& genome, unsigned int start){
     // confirm start codon
     assert(genome.getGene(start) == startCode1);
     assert(genome.getGene(start+1) == startCode2);
@@ -17,9 +17,9 @@ void nHMMUnit::setup(nGenome genome, unsigned int start){
     int read = start + 2;
     
     // number of inputs 
-    unsigned int numInputs = 1 + (unsigned int)(genome.getGene(read++) & (HMMFanIn - 1));
+    unsigned int numInputs = 1 + (unsigned int)(genome.getGene(read++) & (params.HMMFanIn - 1));
     // number of outputs
-    unsigned int numOutputs = 1 + (unsigned int)(genome.getGene(read++) & (HMMFanOut - 1));
+    unsigned int numOutputs = 1 + (unsigned int)(genome.getGene(read++) & (params.HMMFanOut - 1));
         
     // clear input and output vectors
     m_inputs.clear();
@@ -28,32 +28,32 @@ void nHMMUnit::setup(nGenome genome, unsigned int start){
     // fill in input nodes
     for (size_t i = 0; i < numInputs; i++){
         // next input
-        unsigned int nextInput = genome.getGene(read + (int)i) % (maxNodes);
+        unsigned int nextInput = genome.getGene(read + (int)i) % (params.maxNodes);
         // avoid repetition
         while (std::find(m_inputs.begin(), m_inputs.end(), nextInput) != m_inputs.end()){
-            nextInput = (nextInput + 1) % maxNodes;
+            nextInput = (nextInput + 1) % params.maxNodes;
         }
         m_inputs.push_back(nextInput);
     }
     
     // set read position after input nodes list on genome
-    read += HMMFanIn;
+    read += params.HMMFanIn;
     
     // fill in output nodes
     for (size_t i = 0; i < numOutputs; i++){
         
         // next output
-        unsigned int nextOutput = genome.getGene(read+(int)i) % (maxNodes);
+        unsigned int nextOutput = genome.getGene(read+(int)i) % (params.maxNodes);
                 
         // avoid repetition
         while (std::find(m_outputs.begin(), m_outputs.end(), nextOutput) != m_outputs.end()){
-            nextOutput = (nextOutput + 1) % (maxNodes);
+            nextOutput = (nextOutput + 1) % (params.maxNodes);
         }        
         m_outputs.push_back(nextOutput);
     }
     
     // set read position after output nodes list on genome
-    read += HMMFanOut;
+    read += params.HMMFanOut;
     
     // setup transition probabilities
     // input states constitute rows
@@ -79,7 +79,7 @@ void nHMMUnit::setup(nGenome genome, unsigned int start){
         }
         
         // if deterministic, winner takes it all
-        if (deterministicHMM) {
+        if (params.deterministicHMM) {
             size_t counter = std::max_element(m_hmm[row].begin(), m_hmm[row].end()) - m_hmm[row].begin();
             m_hmm[row].clear();
             m_hmm[row].resize(1 << numOutputs);
@@ -91,29 +91,6 @@ void nHMMUnit::setup(nGenome genome, unsigned int start){
     
 }
 
-void nHMMUnit::fire(unsigned long &inState, unsigned long &outState){
-    
-    // input state corresponding to inputs of "this" unit
-    int inputState = 0;
-    
-    // extract the state corresponding to inputs (which identifies the row)
-    for (size_t i = 0; i < m_inputs.size(); i++)
-        inputState = (inputState << 1) + ((inState >> m_inputs[i])&1);
- 
-    // generate a number (drop a niddle) between 0, sum[row]
-    unsigned long dropper = (deterministicHMM)? 1 : (unsigned long)genUniRand(0, m_sums[inputState]);
-    
-    unsigned long total(m_hmm[inputState][0]), j(0);
-    while (dropper > total)
-        total += m_hmm[inputState][++j];
-    
-    outState = inState;
-    
-    for (unsigned int i=0; i < m_outputs.size(); i++) {
-        (((j >> i)&1) == true) ? (outState |= 1 << m_outputs[i]) : ( outState &= ~(1 << m_outputs[i]));
-    }
-}
-
 void nHMMUnit::printUnit(std::ostream& fout){
 
     size_t numInputs(m_inputs.size()), numOutputs(m_outputs.size());
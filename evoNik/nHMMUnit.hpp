@@ -7,6 +7,8 @@
 //
 //  Short Description :
 //  A class handling the Hidden Markov Model (HMM) units.
+//  (as decoded from the genome; brains fire their compiled
+//  nHMMKernel form)
 //
 
 #ifndef evoNik_nHmmUnit_hpp
@@ -34,13 +36,19 @@ public:
     
     
     // constructor
-    nHMMUnit(nGenome g, unsigned int position){
+    nHMMUnit(const nGenome& g, unsigned int position){
         this->setup(g, position);
     }
     
     // Default constructor
     nHMMUnit(){
     }
+    
+    // copy and move (the tables are taken over)
+    nHMMUnit(const nHMMUnit&) = default;
+    nHMMUnit(nHMMUnit&&) = default;
+    nHMMUnit& operator = (const nHMMUnit&) = default;
+    nHMMUnit& operator = (nHMMUnit&&) = default;
     // destructor
     ~nHMMUnit(){
         m_hmm.clear();
@@ -51,9 +59,7 @@ public:
     
     // member functions
     // setup the HMM using information encoded in a genome
-    void setup(nGenome genome, unsigned int start);
-    // fire an HMM to generate output from input states
-    void fire(unsigned long &inState, unsigned long &outState);
+    void setup(const nGenome& genome, unsigned int start);
     // print the HMM
     void printUnit(std::ostream& fout = std::cout);
     
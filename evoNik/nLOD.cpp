@@ -0,0 +1,331 @@
+//
+//  nLOD.cpp
+//  evoNik
+//
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "nLOD.hpp"
+
+// entry header lines
+static const std::string genHeader("# Gen no. ");
+static const std::string keyframeHeader("# Printing genome for agent no. ");
+static const std::string editsHeader("# Edits for agent no. ");
+static const std::string crossingHeader("# Lineage crossed islands: ");
+
+// does the line start with the header
+static bool startsWith(const std::string& line, const std::string& header){
+    return line.compare(0, header.size(), header) == 0;
+}
+
+// genes of a line (tab separated)
+static void parseGenes(const std::string& line, std::vector<unsigned int>& genes){
+    genes.clear();
+    std::istringstream tokens(line);
+    unsigned int gene;
+    while (tokens >> gene)
+        genes.push_back(gene);
+}
+
+
+bool nLOD::crossing(unsigned int genID, const nAgent& a, std::string& marker) const{
+
+    // (only immigrant lineages skip generations)
+    if (!m_written || genID <= m_lastGenID + 1)
+        return false;
+
+    std::ostringstream line;
+    line << crossingHeader << "no ancestor in generations " << m_lastGenID + 1 << " to " << genID - 1;
+    if (a.m_origin.island >= 0)
+        line << " (immigrant from island " << a.m_origin.island << ", agent no. " << a.m_origin.id
+        << " of gen no. " << a.m_origin.generation << " there)";
+    else
+        line << " (descends from immigrants)";
+
+    marker = line.str();
+    return true;
+}
+
+
+void nLOD::write(unsigned int genID, nAgent& a){
+
+    std::string marker;
+    if (crossing(genID, a, marker))
+        *m_output << marker << std::endl;
+
+    *m_output << genHeader << genID
+    << " (agent fitness = " << a.m_fitness
+    << "):" << std::endl;
+
+    // a keyframe every m_keyframeInterval generations, and wherever the previous
+    // entry is not the parent generation (or differs too much to be worth the edits)
+    bool keyframe = m_keyframeInterval < 2 || genID % m_keyframeInterval == 0 || !m_written || genID != m_lastGenID + 1;
+    std::ostringstream edits;
+    if (!keyframe)
+        keyframe = !diff(m_lastGenome, a.m_genome.m_genome, edits, a.m_genome.getSize()/4);
+
+    if (keyframe)
+        a.printGenome(*m_output);
+    else {
+        *m_output << editsHeader << a.m_id << std::endl;
+        *m_output << (edits.str().empty() ? "=0\t" : edits.str()) << std::endl;
+    }
+
+    m_lastGenome = a.m_genome.m_genome;
+    m_written = true;
+    m_lastGenID = genID;
+}
+
+
+bool nLOD::readGeneration(std::istream& input, unsigned int genID, nGenome& genome){
+    return read(input, genID, false, genome);
+}
+
+
+bool nLOD::readAgent(std::istream& input, unsigned int agentID, nGenome& genome){
+    return read(input, agentID, true, genome);
+}
+
+
+bool nLOD::readNext(std::istream& input, unsigned int& genID, unsigned int& agentID, double& fitness, nGenome& genome,
+                    std::string* marker){
+
+    if (marker != NULL)
+        marker->clear();
+
+    std::string line;
+    while (getline(input, line)) {
+
+        if (startsWith(line, crossingHeader)) {
+            if (marker != NULL)
+                *marker = line;
+            continue;
+        }
+
+        if (startsWith(line, genHeader)) {
+            genID = (unsigned int)std::atoi(line.c_str() + genHeader.size());
+            size_t equals = line.find('=');
+            fitness = (equals == std::string::npos) ? 0 : std::atof(line.c_str() + equals + 1);
+            continue;
+        }
+
+        bool isKeyframe = startsWith(line, keyframeHeader);
+        if (!isKeyframe && !startsWith(line, editsHeader))
+            continue;
+
+        agentID = (unsigned int)std::atoi(line.c_str() + line.rfind(' ') + 1);
+        if (!getline(input, line))
+            break;
+
+        // (edits without a keyframe before them can not be applied)
+        if (isKeyframe)
+            parseGenes(line, genome.m_genome);
+        else if (genome.m_genome.empty())
+            continue;
+        else if (!patch(genome.m_genome, line)) {
+            std::cerr << "Error in nLOD: edits of the entry of generation " << genID
+            << " do not fit the genome before it" << std::endl;
+            exit(1);
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+
+bool nLOD::read(std::istream& input, unsigned int id, bool byAgent, nGenome& genome){
+
+    // the last keyframe and the edits since (only parsed for the entry looked for)
+    std::string line, keyframe;
+    std::vector<std::string> edits;
+    bool keyframeRead = false;
+    unsigned int genID = 0;
+
+    while (getline(input, line)) {
+
+        if (startsWith(line, genHeader)) {
+            genID = (unsigned int)std::atoi(line.c_str() + genHeader.size());
+            continue;
+        }
+
+        bool isKeyframe = startsWith(line, keyframeHeader);
+        if (!isKeyframe && !startsWith(line, editsHeader))
+            continue;
+
+        unsigned int agentID = (unsigned int)std::atoi(line.c_str() + line.rfind(' ') + 1);
+        if (!getline(input, line))
+            break;
+
+        if (isKeyframe) {
+            keyframe.swap(line);
+            edits.clear();
+            keyframeRead = true;
+        }
+        else if (keyframeRead)
+            edits.push_back(line);
+
+        // (edits without a keyframe before them can not be applied)
+        if ((byAgent ? agentID : genID) != id || !keyframeRead)
+            continue;
+
+        parseGenes(keyframe, genome.m_genome);
+        for (size_t i = 0; i < edits.size(); i++)
+            if (!patch(genome.m_genome, edits[i])) {
+                std::cerr << "Error in nLOD: edits of the entry of generation " << genID
+                << " do not fit the genome before it" << std::endl;
+                exit(1);
+            }
+
+        return true;
+    }
+
+    return false;
+}
+
+
+bool nLOD::diff(const std::vector<unsigned int>& from, const std::vector<unsigned int>& to, std::ostream& edits,
+                size_t maxEdits){
+
+    // the common head and tail are kept
+    size_t head = 0;
+    while (head < from.size() && head < to.size() && from[head] == to[head])
+        head++;
+    size_t tail = 0;
+    while (tail < from.size() - head && tail < to.size() - head &&
+           from[from.size() - 1 - tail] == to[to.size() - 1 - tail])
+        tail++;
+
+    const unsigned int* a = from.data() + head;
+    const unsigned int* b = to.data() + head;
+    long n = (long)(from.size() - head - tail), m = (long)(to.size() - head - tail);
+
+    // shortest edit script of the rest (Myers' greedy algorithm): trace[d][k + d] is
+    // the furthest x reached on diagonal k = x - y with d genes dropped or inserted
+    std::vector<std::vector<long> > trace;
+    bool reached = false;
+    for (long d = 0; !reached; d++) {
+        if ((size_t)d > maxEdits)
+            return false;
+
+        std::vector<long> v(2*d + 1);
+        for (long k = -d; k <= d; k += 2) {
+            long x = 0;
+            if (d > 0) {
+                const std::vector<long>& previous = trace.back();
+                // down (insert) from diagonal k+1, or right (drop) from k-1
+                if (k == -d || (k != d && previous[k - 1 + d - 1] < previous[k + 1 + d - 1]))
+                    x = previous[k + 1 + d - 1];
+                else
+                    x = previous[k - 1 + d - 1] + 1;
+            }
+
+            long y = x - k;
+            while (x < n && y < m && a[x] == b[y]) {
+                x++;
+                y++;
+            }
+            v[k + d] = x;
+
+            if (x >= n && y >= m) {
+                reached = true;
+                break;
+            }
+        }
+        trace.push_back(v);
+    }
+
+    // walk back from the end: kept runs, dropped genes (index in a) and inserted genes
+    // (index in b), listed backwards
+    enum{ KEEP, DROP, INSERT };
+    std::vector<std::pair<int, long> > steps;
+    long x = n, y = m;
+    for (long d = (long)trace.size() - 1; d > 0; d--) {
+        const std::vector<long>& previous = trace[d - 1];
+        long k = x - y;
+        bool down = (k == -d || (k != d && previous[k - 1 + d - 1] < previous[k + 1 + d - 1]));
+        long pk = down ? k + 1 : k - 1;
+        long px = previous[pk + d - 1], py = px - pk;
+        long snakeStart = down ? px : px + 1;
+
+        if (x > snakeStart)
+            steps.push_back(std::make_pair((int)KEEP, x - snakeStart));
+        steps.push_back(down ? std::make_pair((int)INSERT, py) : std::make_pair((int)DROP, px));
+        x = px;
+        y = py;
+    }
+    if (x + (long)head > 0)
+        steps.push_back(std::make_pair((int)KEEP, x + (long)head));
+
+    // forwards, the drops and inserts between two kept runs merged (the tail is kept anyway)
+    long kept = 0, dropped = 0;
+    std::vector<unsigned int> inserted;
+    for (size_t i = steps.size() + 1; i-- > 0; ) {
+        if (i == 0 || steps[i - 1].first == KEEP) {
+            if (kept > 0 && (dropped > 0 || !inserted.empty()))
+                edits << "=" << kept << "\t";
+            if (dropped > 0)
+                edits << "-" << dropped << "\t";
+            if (!inserted.empty()) {
+                edits << "+";
+                for (size_t j = 0; j < inserted.size(); j++)
+                    edits << (j ? "," : "") << inserted[j];
+                edits << "\t";
+            }
+            if (dropped > 0 || !inserted.empty())
+                kept = 0;
+            dropped = 0;
+            inserted.clear();
+            if (i > 0)
+                kept += steps[i - 1].second;
+        }
+        else if (steps[i - 1].first == DROP)
+            dropped++;
+        else
+            inserted.push_back(b[steps[i - 1].second]);
+    }
+
+    return true;
+}
+
+
+bool nLOD::patch(std::vector<unsigned int>& genome, const std::string& edits){
+
+    std::vector<unsigned int> patched;
+    patched.reserve(genome.size());
+    size_t at = 0;
+
+    std::istringstream tokens(edits);
+    std::string token;
+    while (tokens >> token) {
+        const char* c = token.c_str() + 1;
+        char* end;
+
+        if (token[0] == '+') {
+            while (*c != '\0') {
+                patched.push_back((unsigned int)std::strtoul(c, &end, 10));
+                if (end == c)
+                    return false;
+                c = (*end == ',') ? end + 1 : end;
+            }
+        }
+        else if (token[0] == '=' || token[0] == '-') {
+            size_t count = std::strtoul(c, &end, 10);
+            if (end == c || at + count > genome.size())
+                return false;
+            if (token[0] == '=')
+                patched.insert(patched.end(), genome.begin() + at, genome.begin() + at + count);
+            at += count;
+        }
+        else
+            return false;
+    }
+
+    // the rest is kept
+    patched.insert(patched.end(), genome.begin() + at, genome.end());
+    genome.swap(patched);
+
+    return true;
+}
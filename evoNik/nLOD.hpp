@@ -0,0 +1,87 @@
+//
+//  nLOD.hpp
+//  evoNik
+//
+//  The line of descent file (lod_output.txt). Every lodKeyframeInterval
+//  generations an entry holds the full genome of the ancestor (a
+//  keyframe, as nAgent::printGenome writes it); in between an entry
+//  holds the edits turning the genome of the previous entry into it.
+//  Ancestors differ by a few mutations, so an entry is a few tokens
+//  instead of the whole genome. A genome is rebuilt from the keyframe
+//  before it, with at most lodKeyframeInterval edit lines applied.
+//
+//  An entry:
+//      # Gen no. <gen> (agent fitness = <fitness>):
+//      # Printing genome for agent no. <id>         (a keyframe)
+//      <gene> <gene> ...
+//  or
+//      # Gen no. <gen> (agent fitness = <fitness>):
+//      # Edits for agent no. <id>
+//      <edit> <edit> ...
+//  with the edits (tab separated, applied left to right over the previous
+//  genome, the genes after the last edit are kept)
+//      =n          keep the next n genes
+//      -n          drop the next n genes
+//      +g,g,...    insert genes
+//
+//  Where the lineage came in with immigrants (an island run, see
+//  nAncestry) the generations in between have no ancestor here; the
+//  entry after them is a keyframe, marked by a line before it:
+//      # Lineage crossed islands: no ancestor in generations <first> to <last>
+//        (immigrant from island <i>, agent no. <id> of gen no. <gen> there)
+//  (on one line; "(descends from immigrants)" if the entry is not one)
+//
+
+#ifndef evoNik_nLOD_hpp
+#define evoNik_nLOD_hpp
+
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "utility.hpp"
+#include "nAgent.hpp"
+
+class nLOD{
+public:
+
+    // constructor with the LOD file and the keyframe interval (0 or 1: keyframes only)
+    nLOD(std::ostream& output, unsigned int keyframeInterval = params.lodKeyframeInterval)
+    :m_output(&output), m_keyframeInterval(keyframeInterval), m_written(false), m_lastGenID(0){
+    }
+
+    // member functions
+    // write the entry of the ancestor of a generation
+    void write(unsigned int genID, nAgent& a);
+    // the marker of the entry of a generation, if the lineage crossed islands before it (false if not)
+    bool crossing(unsigned int genID, const nAgent& a, std::string& marker) const;
+
+    // rebuild the genome of a generation (false if not in the file)
+    static bool readGeneration(std::istream& input, unsigned int genID, nGenome& genome);
+    // rebuild the genome of an agent (false if not in the file)
+    static bool readAgent(std::istream& input, unsigned int agentID, nGenome& genome);
+    // read the next entry, its genome rebuilt from the genome of the entry read before
+    // (empty before the first one; false at the end of the file), and its crossing marker (or none)
+    static bool readNext(std::istream& input, unsigned int& genID, unsigned int& agentID, double& fitness, nGenome& genome,
+                         std::string* marker = NULL);
+    // the edits turning one genome into another (false if it takes more than maxEdits dropped/inserted genes)
+    static bool diff(const std::vector<unsigned int>& from, const std::vector<unsigned int>& to, std::ostream& edits,
+                     size_t maxEdits = std::numeric_limits<size_t>::max());
+    // apply edits to a genome (false if they do not fit it)
+    static bool patch(std::vector<unsigned int>& genome, const std::string& edits);
+
+private:
+    // LOD file
+    std::ostream* m_output;
+    // generations between keyframes
+    unsigned int m_keyframeInterval;
+    // genome of the last entry (edits are against it)
+    std::vector<unsigned int> m_lastGenome;
+    bool m_written;
+    unsigned int m_lastGenID;
+
+    // rebuild the genome of the entry with the given generation (byAgent: agent) id
+    static bool read(std::istream& input, unsigned int id, bool byAgent, nGenome& genome);
+};
+
+#endif
@@ -12,109 +12,310 @@
 // 0 is a wall
 // 1 is a door
 
+#include <algorithm>
+#include <cstdlib>
+
+#include <boost/atomic.hpp>
+#include <boost/cstdint.hpp>
+
 #include "nMaze.hpp"
 
-bool nMaze::isValid(){
+// streams of draws (per position)
+enum{
+    DRAW_GAP,
+    DRAW_DOOR,
+    DRAW_FOOD
+};
+
+// doors ordered by column
+static bool leftOf(const position& door, unsigned int x){
+    return door.x < (int)x;
+}
+
+// steps between two positions of one open stretch of the maze
+static double steps(const position& a, const position& b){
+    return std::abs(a.x - b.x) + std::abs(a.y - b.y);
+}
+
+
+bool nMaze::isValid() const{
     
     // check if zero area
     if (m_x ==0 || m_y==0)
         return false;
     
-    // if floor plan exists
-    if (m_plan.empty())
+    // if there is no way in (no room for the first wall)
+    if (m_entry.x >= (int)m_x - 1)
         return false;
     
     return true;
 }
 
 
+// plans created so far (process-wide, for unique maze ids)
+static boost::atomic<unsigned int> plansCreated(0);
+
 void nMaze::create(){
     
+    boost::lock_guard<boost::mutex> lock(m_mutex);
+    
+    // a new plan
+    m_id = ++plansCreated;
+    m_seed = genRandInt();
+    
     // clear previous plan
-    m_plan.clear();
+    dropChunks();
+    m_clock = 0;
     m_doors.clear();
-       
-    // create floor plan area
-    m_plan.resize(m_x);
-    for (size_t i = 0; i < m_x; i++) {
-        m_plan[i].resize(m_y);
-    }
+    m_food = false;
+    m_goalSet = false;
+    m_doorDistances.clear();
     
-    // create a wall border
-    for (size_t i = 0; i < m_x; i++) {
-        m_plan[i][0] = 1;   // top
-        m_plan[i][m_y-1] = 1; // bottom
-    }
+    // the first wall (its door not at extreme y values)
+    m_nextDoor = position(1, 2 + (unsigned int)(draw(1, 0, DRAW_DOOR)*(m_y - 4)));
+    m_entry = m_nextDoor;
+}
+
+
+void nMaze::dropChunks(){
     
-    // create obstructing walls 
-    // (with one hole at random position)
-    unsigned int xPos(1), doorPos(0);
-    unsigned int prevWallPos(-1), prevDoorPos(m_y);
+    m_chunks.clear();
+    m_lastUse.clear();
+    m_chunksHeld = 0;
+}
+
+
+void nMaze::layWalls(unsigned int x) const{
     
-    while (xPos < m_x-1) {
-        // creat a wall
-        for (size_t i = 0; i < m_y; i++)
-            m_plan[xPos][i] = 1;
-        
-        // bore a hole at some random location
-        if (xPos != prevWallPos+1)     // if adjescent walls, match door positions, else
-            doorPos = (xPos == 1)? (unsigned int)genUniRand(2, m_y-2) : (unsigned int)genUniRand(1, m_y-1);   // first wall door is not at extreme y values 
+    // obstructing walls with one hole each
+    while (m_nextDoor.x <= (int)x && m_nextDoor.x < (int)m_x - 1) {
+        m_doors.push_back(m_nextDoor);
         
-        m_plan[xPos][doorPos] = 0;
+        // next wall at a distance (1-3) units from this wall
+        unsigned int gap = 1 + (unsigned int)(draw(m_nextDoor.x, 0, DRAW_GAP)*3);
+        m_nextDoor.x += gap;
         
-        // update door list
-        m_doors.push_back(position(xPos, doorPos));
+        // adjacent walls match door positions
+        if (gap > 1)
+            m_nextDoor.y = 1 + (unsigned int)(draw(m_nextDoor.x, 0, DRAW_DOOR)*(m_y - 2));
+    }
+}
 
-        // if "this" door is on the right of "previous"
-        // insert a flag (second bit in floor plan is set)
-        if (doorPos > prevDoorPos)
-            m_plan[prevWallPos][prevDoorPos]=2;
-        
-        // "this" becomes previous wall n door        
-        prevWallPos = xPos;
-        prevDoorPos = doorPos;
+
+nMaze::chunkPtr nMaze::getChunk(unsigned int x) const{
+    
+    boost::lock_guard<boost::mutex> lock(m_mutex);
+    
+    size_t k = x / m_chunkSize;
+    if (k < m_chunks.size() && m_chunks[k]) {
+        m_lastUse[k] = ++m_clock;
+        return m_chunks[k];
+    }
+    
+    return generateChunk(k);
+}
+
+
+size_t nMaze::getChunksHeld() const{
+    
+    boost::lock_guard<boost::mutex> lock(m_mutex);
+    return m_chunksHeld;
+}
+
+
+nMaze::chunkPtr nMaze::generateChunk(size_t k) const{
+    
+    if (k >= m_chunks.size()) {
+        m_chunks.resize(k + 1);
+        m_lastUse.resize(k + 1);
+    }
+    
+    // make room: drop the least recently used chunk (its readers keep it)
+    if (m_chunksHeld >= m_chunkCache) {
+        size_t oldest = m_chunks.size();
+        for (size_t i = 0; i < m_chunks.size(); i++)
+            if (m_chunks[i] && (oldest == m_chunks.size() || m_lastUse[i] < m_lastUse[oldest]))
+                oldest = i;
+        m_chunks[oldest].reset();
+        m_chunksHeld--;
+    }
+    
+    boost::shared_ptr<chunk> c(new chunk);
+    c->x0 = k*m_chunkSize;
+    c->width = m_chunkSize;
+    c->height = m_y;
+    
+    // create floor plan area with a wall border (top, bottom)
+    unsigned int x0 = c->x0;
+    c->plan.assign(m_chunkSize*m_y, 0);
+    for (size_t i = 0; i < m_chunkSize; i++) {
+        c->plan[i*m_y] = 1;
+        c->plan[i*m_y + m_y - 1] = 1;
+    }
+    
+    // the walls in the chunk (and the one after the last)
+    layWalls(x0 + m_chunkSize + 3);
+    
+    for (size_t d = std::lower_bound(m_doors.begin(), m_doors.end(), x0, leftOf) - m_doors.begin();
+         d < m_doors.size() && m_doors[d].x < (int)(x0 + m_chunkSize); d++) {
+        unsigned int* column = &c->plan[(m_doors[d].x - x0)*m_y];
+        std::fill(column, column + m_y, 1);
+        column[m_doors[d].y] = 0;
         
-        // choose next wall position 
-        // at a distance (1-4) units from this wall
-        xPos += (unsigned int)genUniRand(1, 4);
+        // if the next door is on the right of "this"
+        // insert a flag (second bit in floor plan is set)
+        if (d + 1 < m_doors.size() && m_doors[d + 1].y > m_doors[d].y)
+            column[m_doors[d].y] = 2;
+    }
+    
+    if (m_food)
+        sprinkleFood(*c);
+    if (m_goalSet)
+        computeFitness(*c);
+    
+    m_chunks[k] = c;
+    m_lastUse[k] = ++m_clock;
+    m_chunksHeld++;
+    
+    return c;
+}
+
+
+double nMaze::draw(unsigned int x, unsigned int y, unsigned int stream) const{
+    
+    // splitmix64 over (seed, x, y, stream)
+    boost::uint64_t z = (static_cast<boost::uint64_t>(m_seed) << 32) | x;
+    for (int round = 0; round < 2; round++) {
+        z += 0x9E3779B97F4A7C15ULL;
+        z = (z ^ (z >> 30))*0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27))*0x94D049BB133111EBULL;
+        z ^= z >> 31;
+        z ^= (static_cast<boost::uint64_t>(y) << 32) | stream;
     }
     
+    return (z >> 11)*(1.0/9007199254740992.0);
 }
 
 
 void nMaze::sprinkleFood(){
-    // move all over the maze    
-    for (unsigned int xPos = 0; xPos < m_x; xPos++)
+    
+    boost::lock_guard<boost::mutex> lock(m_mutex);
+    
+    // the chunks generated from here on (the ones held are generated again)
+    m_food = true;
+    dropChunks();
+}
+
+
+void nMaze::sprinkleFood(chunk& c) const{
+    // move all over the chunk
+    for (unsigned int i = 0; i < m_chunkSize; i++)
         for (unsigned int yPos = 1; yPos < m_y - 1; yPos++)
             
             // if there is no wall at xPos, yPos create a food bag
-            if (m_plan[xPos][yPos] != 1)                
+            if (c.plan[i*m_y + yPos] != 1)
                 // adjust the "third" bit of m_plan to have food item
                 // either a healthy (1) or poisonous food (0) 
                 // randomly
-                if (genUniRand(0, 1) > 0.5)
-                    applyBit(m_plan[xPos][yPos], 2, 1);
+                if (draw(c.x0 + i, yPos, DRAW_FOOD) > 0.5)
+                    applyBit(c.plan[i*m_y + yPos], 2, 1);
 }
 
 
-void nMaze::printMaze(std::ostream& fout){
+void nMaze::printMaze(std::ostream& fout) const{
     
     // header
     fout << "# The maze (floor) plan: " << std::endl;
     
     for (size_t y = 0; y < m_y; y++) {
         for (size_t x = 0; x < m_x; x++) 
-            fout << m_plan[x][y] << "\t";
+            fout << cell(x, y) << "\t";
         fout << std::endl;
     }
 }
 
-void nMaze::replanishFood(){
+
+void nMaze::setGoal(position goal){
     
-    // the "forth" bit in m_plan corresponds to a consumed food
-    // make it available again
-    for (unsigned int xPos = 0; xPos < m_x; xPos++)
-        for (unsigned int yPos = 1; yPos < m_y - 1; yPos++)
-            if (m_plan[xPos][yPos] != 1)
-                applyBit(m_plan[xPos][yPos], 3, 0);
+    boost::lock_guard<boost::mutex> lock(m_mutex);
+    
+    m_goal = goal;
+    m_goalSet = true;
+    
+    // only up to the reach of the goal (plus a column) counts for the farthest position
+    unsigned int width = std::min<unsigned int>(goal.x + 2, m_x);
+    layWalls(width + 3);
+    
+    // doors left of the goal lead to it through the doors in between
+    m_doorDistances.assign(std::lower_bound(m_doors.begin(), m_doors.end(), goal.x, leftOf) - m_doors.begin(), -1);
+    position next = goal;
+    double distance(0);
+    for (size_t d = m_doorDistances.size(); d-- > 0; ) {
+        distance += steps(m_doors[d], next);
+        m_doorDistances[d] = distance;
+        next = m_doors[d];
+    }
+    
+    m_maxDistance = 0;
+    for (unsigned int x = 0; x < width; x++)
+        for (unsigned int y = 1; y < m_y - 1; y++)
+            m_maxDistance = std::max(m_maxDistance, this->distance(x, y));
+    
+    if (!params.suppressMessages)
+        std::cout << " max_distance=" << m_maxDistance << std::endl;
+    
+    // the fitness landscape changed (the chunks held are generated again)
+    dropChunks();
+}
+
+
+double nMaze::doorDistance(size_t i) const{
+    
+    // doors right of the goal lead to it through the doors in between
+    for (size_t d = m_doorDistances.size(); d <= i; d++) {
+        if (d == 0 || m_doors[d - 1].x < m_goal.x)
+            m_doorDistances.push_back(steps(m_doors[d], m_goal));
+        else
+            m_doorDistances.push_back(steps(m_doors[d], m_doors[d - 1]) + m_doorDistances[d - 1]);
+    }
+    
+    return m_doorDistances[i];
+}
+
+
+double nMaze::distance(unsigned int x, unsigned int y) const{
+    
+    // the border
+    if (y == 0 || y >= m_y - 1)
+        return -1;
+    
+    // the walls (up to the one after x)
+    layWalls(x + 3);
+    size_t d = std::lower_bound(m_doors.begin(), m_doors.end(), x, leftOf) - m_doors.begin();
+    size_t goalSide = std::lower_bound(m_doors.begin(), m_doors.end(), m_goal.x, leftOf) - m_doors.begin();
+    position here(x, y);
+    
+    // in a wall
+    if (d < m_doors.size() && m_doors[d].x == (int)x)
+        return (m_doors[d].y == (int)y) ? doorDistance(d) : -1;
+    
+    // between the doors d-1 and d, the goal in the same stretch, on the right or on the left
+    if (d == goalSide)
+        return steps(here, m_goal);
+    else if (d < goalSide)
+        return steps(here, m_doors[d]) + doorDistance(d);
+    else
+        return steps(here, m_doors[d - 1]) + doorDistance(d - 1);
+}
+
+
+void nMaze::computeFitness(chunk& c) const{
+    
+    c.fitness.resize(m_chunkSize*m_y);
+    for (unsigned int i = 0; i < m_chunkSize; i++)
+        for (unsigned int y = 0; y < m_y; y++) {
+            double d = distance(c.x0 + i, y);
+            // (beyond the reach of the goal fitness bottoms out)
+            c.fitness[i*m_y + y] = (d < 0) ? -1 : std::max(0.0, (m_maxDistance - d)/m_maxDistance);
+        }
 }
@@ -5,18 +5,55 @@
 //  Created by Nikhil Joshi on 3/21/12.
 //  Copyright (c) 2012 California Institute of Technology. All rights reserved.
 //
+//  The maze is generated lazily, in chunks of mazeChunkSize columns, as
+//  agents (and the solver) reach them. Walls, doors and food are drawn
+//  from a hash of the maze seed and the position, so a chunk comes out
+//  the same whenever (and however often) it is generated; at most
+//  mazeChunkCache chunks are held, the least recently used ones are
+//  dropped. A chunk does not change once generated, and whoever reads it
+//  keeps it (see getChunk) as long as needed, dropped by the maze or not.
+//  Reading the maze is thread safe: only finding (or generating) a chunk
+//  is locked. So once its goal and food are set, one maze serves any
+//  number of concurrent games (eaten food is kept by the game, see nGame).
+//
+//  The fitness of a position is its (normalized) distance to the goal.
+//  Between two walls the maze is an open rectangle, so distances follow
+//  from the doors alone and are worked out per chunk as it is generated.
+//
 
 #ifndef evoNik_nMaze_hpp
 #define evoNik_nMaze_hpp
 
+#include <boost/shared_ptr.hpp>
+
 #include "utility.hpp"
 #include "nAgent.hpp"
 
 class nMaze{
 public:
     
+    // a run of columns of the maze (not changed once generated)
+    struct chunk{
+        // first column, columns, rows
+        unsigned int x0, width, height;
+        // floor plan (column major)
+        std::vector<unsigned int> plan;
+        // fitness landscape (column major, empty without a goal)
+        std::vector<double> fitness;
+        
+        // does it hold a column
+        bool covers(unsigned int x) const                        { return x - x0 < width; }
+        // floor plan at a position
+        unsigned int cell(unsigned int x, unsigned int y) const  { return plan[(x - x0)*height + y]; }
+        // fitness at a position
+        double getFitness(unsigned int x, unsigned int y) const  { return fitness.empty() ? 0 : fitness[(x - x0)*height + y]; }
+    };
+    typedef boost::shared_ptr<const chunk> chunkPtr;
+    
     // constructor
-    nMaze(unsigned int x, unsigned y):m_x(x), m_y(y){
+    nMaze(unsigned int x, unsigned y,
+          unsigned int chunkSize = params.mazeChunkSize, unsigned int chunkCache = params.mazeChunkCache)
+    :m_x(x), m_y(y), m_chunkSize(chunkSize), m_chunkCache(chunkCache){
         create();
     }
     
@@ -27,37 +64,88 @@ public:
     
     // member functions
     // get dimensions
-    unsigned int getX(void)                                      { return m_x; }
-    unsigned int getY(void)                                      { return m_y; }    
-    // get door plan
-    std::vector<position>& getDoors(void)                         { return m_doors;  }
-    // get floor plan
-    std::vector<std::vector<unsigned int>>& getFloorPlan(void)    { return m_plan; }
-    // get fitness landscape
-    std::vector<std::vector<double>>& getFitnessLandscape(void)   { return m_fitnessLandscape; }
+    unsigned int getX(void) const                                { return m_x; }
+    unsigned int getY(void) const                                { return m_y; }    
+    // get id (a new one for every created plan)
+    unsigned int getID(void) const                               { return m_id; }
+    // get the entry (the door of the first wall)
+    position getEntry(void) const                                { return m_entry; }
+    // the chunk holding a column (generated if needed)
+    chunkPtr getChunk(unsigned int x) const;
+    // floor plan at a position (bit 0: wall, 1: next door to the right, 2: healthy food)
+    unsigned int cell(unsigned int x, unsigned int y) const      { return getChunk(x)->cell(x, y); }
+    // fitness at a position (1 at the goal)
+    double fitness(unsigned int x, unsigned int y) const         { return getChunk(x)->getFitness(x, y); }
+    // set the goal (and with it the fitness landscape)
+    void setGoal(position goal);
+    // number of chunks held at the moment
+    size_t getChunksHeld(void) const;
     // create maze
     void create(void);
     // is it a valid maze
-    bool isValid(void);
+    bool isValid(void) const;
     // write or print
-    void printMaze(std::ostream& fout = std::cout);
+    void printMaze(std::ostream& fout = std::cout) const;
     // render maze
     void display(void);
     // sprinkle food items
     void sprinkleFood(void);
-    // replanish fresh food
-    void replanishFood(void);
     
 private:
     //maze dimensions
     unsigned int m_x, m_y;
-    // floor plan
-    std::vector<std::vector<unsigned int> > m_plan;
-    // fitness landscape
-    std::vector<std::vector<double> > m_fitnessLandscape;
-    // door position list
-    std::vector<position> m_doors;
+    // columns per chunk, max. chunks held
+    unsigned int m_chunkSize, m_chunkCache;
+    // id of the current plan
+    unsigned int m_id;
+    // seed of the current plan
+    unsigned int m_seed;
+    // the entry
+    position m_entry;
+    // food sprinkled
+    bool m_food;
+    
+    // goal, its distance from the farthest position (within the reach of the goal)
+    position m_goal;
+    bool m_goalSet;
+    double m_maxDistance;
+    
+    // guards what reading the maze changes (below)
+    mutable boost::mutex m_mutex;
+    // chunks (NULL if not held) and their last use (for dropping the least recently used)
+    mutable std::vector<chunkPtr> m_chunks;
+    mutable std::vector<unsigned long> m_lastUse;
+    mutable size_t m_chunksHeld;
+    // use clock
+    mutable unsigned long m_clock;
+    // door position list (of the walls laid out so far)
+    mutable std::vector<position> m_doors;
+    // the wall to be laid out next
+    mutable position m_nextDoor;
+    // distance of every door to the goal (worked out so far)
+    mutable std::vector<double> m_doorDistances;
+    
+    // (the members below are called with the maze locked)
+    // drop the chunks held (to be generated again as needed)
+    void dropChunks(void);
+    // generate chunk k
+    chunkPtr generateChunk(size_t k) const;
+    // lay out the walls up to column x
+    void layWalls(unsigned int x) const;
+    // sprinkle food over a chunk
+    void sprinkleFood(chunk& c) const;
+    // work out the fitness landscape of a chunk
+    void computeFitness(chunk& c) const;
+    // distance of a position to the goal (-1: wall)
+    double distance(unsigned int x, unsigned int y) const;
+    // distance of door i to the goal
+    double doorDistance(size_t i) const;
+    // uniform number in [0, 1) drawn for a position of the plan
+    double draw(unsigned int x, unsigned int y, unsigned int stream) const;
     
+    // not copyable
+    nMaze(const nMaze&);
+    nMaze& operator = (const nMaze&);
 };
 
 #endif
@@ -8,24 +8,83 @@
 
 #include <iostream>
 
-#include "nPopulation.hpp"
+#include <boost/scoped_ptr.hpp>
 
-unsigned int nPopulation::generationID = 0;
+#include "nPopulation.hpp"
+#include "nSelection.hpp"
+#include "nScheduler.hpp"
 
 void nPopulation::rank(void){
     
-    if (m_id > static_cast<unsigned int>((selectionPressureFromGeneration/100.0)*maxGenerations) &&
-        m_id < static_cast<unsigned int>((selectionPressureUpToGeneration/100.0)*maxGenerations)) {
+    // nothing changed since the last ranking
+    if (m_ranked)
+        return;
+    
+    if (underSelectionPressure()) {
       
-        // ascending order in fitness
-        std::sort(m_members.begin(), m_members.end(), compareFitnesses());
-        // reverse: best fit guy gets index 0 and so on
-        std::reverse(m_members.begin(), m_members.end());
+        // descending order in fitness: best fit guy gets index 0 and so on
+        std::sort(m_members.begin(), m_members.end(), fitterThan());
     }
     // set as ranked
     m_ranked = true;
 }
 
+
+bool nPopulation::underSelectionPressure(void){
+    return m_id > static_cast<unsigned int>((params.selectionPressureFromGeneration/100.0)*params.maxGenerations) &&
+    m_id < static_cast<unsigned int>((params.selectionPressureUpToGeneration/100.0)*params.maxGenerations);
+}
+
+
+void nPopulation::updateStatistics(void){
+    
+    // nothing changed since the last pass
+    if (m_statisticsValid)
+        return;
+    
+    m_minFitness = m_maxFitness = m_averageFitness = 0;
+    m_elite = NULL;
+    
+    // min, max (the elite) and mean in one pass
+    for (std::vector<nAgent*>::iterator it = m_members.begin();
+         it != m_members.end(); it++) {
+        if (m_elite == NULL || (*it)->m_fitness > m_maxFitness) {
+            m_maxFitness = (*it)->m_fitness;
+            m_elite = *it;
+        }
+        if (it == m_members.begin() || (*it)->m_fitness < m_minFitness)
+            m_minFitness = (*it)->m_fitness;
+        m_averageFitness += (*it)->m_fitness;
+    }
+    
+    if (!m_members.empty())
+        m_averageFitness /= m_members.size();
+    
+    m_statisticsValid = true;
+}
+
+
+void nPopulation::keepFittest(unsigned int size){
+    
+    // the fittest ones first (an unevaluated population keeps its first born)
+    if (m_evaluated && !m_ranked && underSelectionPressure())
+        std::nth_element(m_members.begin(), m_members.begin() + size, m_members.end(), fitterThan());
+    
+    for (std::vector<nAgent*>::iterator it = m_members.begin() + size;
+         it != m_members.end(); it++) {
+        // the ancestry frees it (keeping its row as long as it has descendants)
+        if (m_ancestry != NULL)
+            m_ancestry->retire(*(*it));
+        else {
+            delete *it; 
+            PROFILE_COUNT(COUNT_AGENTS_FREED, 1);
+        }
+    }
+    
+    m_members.erase(m_members.begin() + size, m_members.end());
+    m_statisticsValid = false;
+}
+
 void nPopulation::printPopulation(std::ostream& fout){
     fout << "# Generation no. " << m_id << std::endl;
     
@@ -37,98 +96,123 @@ void nPopulation::printPopulation(std::ostream& fout){
 }
 
 double nPopulation::getAverageFitness(){
-    double ave(0.0);
-    
-    for (std::vector<nAgent*>::iterator it = m_members.begin();
-         it != m_members.end(); it++)
-        ave += (*it)->m_fitness;
-    
-    return (m_members.size()==0) ? 0 : ave / m_members.size();
-    
+    updateStatistics();
+    return m_averageFitness;
 }
 
 
 double nPopulation::getMaxFitness(){
-    // rank the generation
-    rank();
-    
-    //return the maximum fitness
-    return m_members.front()->m_fitness;
+    updateStatistics();
+    return m_maxFitness;
 }
 
 double nPopulation::getMinFitness(){
-    // rank the generation
-    rank();
-    
-    // return the minimum fitness
-    return m_members.back()->m_fitness;
+    updateStatistics();
+    return m_minFitness;
 }
 
 nAgent* nPopulation::getElite(){
-    rank();
-    return m_members[0];
+    updateStatistics();
+    return m_elite;
 }
 
 
-void nPopulation::populate(unsigned int size){
+std::vector<nAgent*> nPopulation::getFittest(unsigned int count){
+    
+    std::vector<nAgent*> fittest(std::min<size_t>(count, m_members.size()));
+    std::partial_sort_copy(m_members.begin(), m_members.end(), fittest.begin(), fittest.end(), fitterThan());
+    return fittest;
+}
 
-    rank();
+
+void nPopulation::immigrate(const std::vector<nGenome>& genomes, const std::vector<nAgent::origin>& origins){
     
-    // if there was "a" master agent
+    // newcomers make up half the population at most
+    size_t count = std::min(genomes.size(), m_members.size()/2);
+    
+    for (size_t i = 0; i < count; i++) {
+        // make room
+        removeAgent(*m_members.back());
+        
+        // a newcomer (its lineage is elsewhere)
+        nAgent* temp = new nAgent;
+        PROFILE_COUNT(COUNT_AGENTS_ALLOCATED, 1);
+        temp->m_genome = genomes[i];
+        temp->m_origin = origins[i];
+        temp->buildHMMs();
+        addAgent(*temp);
+    }
+}
+
+
+void nPopulation::populate(unsigned int size){
+
+    // if there was "a" master agent (the elite one)
     if (m_members.size()!= 0) {
+        nAgent* master = getElite();
         while (m_members.size() < size) {
-            nAgent* temp = new nAgent(m_members[0]->inheriteViaMutation());
+            nAgent* temp = new nAgent(master->inheriteViaMutation());
+            PROFILE_COUNT(COUNT_AGENTS_ALLOCATED, 1);
+            temp->buildHMMs();
+            if (m_ancestry != NULL)
+                m_ancestry->add(*temp, m_id);
             m_members.push_back(temp);
         }
     } else {
         while (m_members.size() < size) {
             nAgent* temp = new nAgent;
+            PROFILE_COUNT(COUNT_AGENTS_ALLOCATED, 1);
             temp->setupRandomGenome();
+            if (m_ancestry != NULL)
+                m_ancestry->add(*temp, m_id);
             m_members.push_back(temp);
         }
     }
 
-    // rank the reorganized population
-    rank();
+    // reorganized population
+    m_ranked = m_statisticsValid = false;
 }
 
 
 void nPopulation::addAgent(nAgent& a){
+    if (m_ancestry != NULL)
+        m_ancestry->add(a, m_id);
     m_members.push_back(&a);
-    m_ranked = false;
-    rank();
+    m_ranked = m_statisticsValid = false;
 }
 
 
 void nPopulation::removeAgent(nAgent& a){
     
+    // (the agent is freed on the way)
+    unsigned int id = a.m_id;
+    
     for (std::vector<nAgent*>::iterator it = m_members.begin();
          it != m_members.end(); it++)
-        if( (*it)->m_id == a.m_id ){
-            a.updateLineage(-1);
-            delete *it; 
+        if( (*it)->m_id == id ){
+            // the ancestry frees it (keeping its row as long as it has descendants)
+            if (m_ancestry != NULL)
+                m_ancestry->retire(*(*it));
+            else {
+                delete *it; 
+                PROFILE_COUNT(COUNT_AGENTS_FREED, 1);
+            }
             m_members.erase(it);
             it--;
+            // (the order of the others is kept)
+            m_statisticsValid = false;
         }
 }
 
 
 void nPopulation::manageSize(){
     
-    // get the population ranked first
-    rank();
-    
     // if the size is bigger
-    if (m_members.size() > populationSize)
-        std::for_each(boost::make_indirect_iterator(m_members.begin() + populationSize), 
-                      boost::make_indirect_iterator(m_members.end()), 
-                      boost::bind(&nPopulation::removeAgent, boost::ref(*this), _1));
+    if (m_members.size() > params.populationSize)
+        keepFittest(params.populationSize);
     // if the size is less 
-    else if(m_members.size() < populationSize)
+    else if(m_members.size() < params.populationSize)
         populate();
-    
-    // rank after reshaping
-    rank();
 }
 
     
@@ -143,17 +227,76 @@ void nPopulation::evaluate(nGame& game){
         exit(1);
     }
     
+    m_gamesPlayed = 0;
+    
     // evaluate fitness for each individual
     for (std::vector<nAgent*>::iterator it = m_members.begin();
-         it != m_members.end(); it++) {
-        m_game->updatePlayer(*(*it));
-        // evaluate a number of times to reduce evaluation error
-        for (unsigned int i = 0; i < evaluationRepetition; i++)
-            m_game->execute();
-    }
+         it != m_members.end(); it++)
+        m_gamesPlayed += m_game->evaluate(*(*it));
     
-    // rank the population
+    // new fitnesses: rank the population (once) and take its statistics
+    m_evaluated = true;
+    m_ranked = m_statisticsValid = false;
     rank();
+    updateStatistics();
+}
+
+
+void nPopulation::makeBrood(size_t brood, std::vector<nAgent*>& children, unsigned int firstID,
+                            nSelector* selector, nRunContext& context){
+
+    // (may be run by a worker thread)
+    nRunContext::scope inContext(context);
+
+    // a random stream of its own, from the run, the generation and the brood
+    size_t seed = context.getSeed();
+    boost::hash_combine(seed, m_id);
+    boost::hash_combine(seed, brood);
+    nRandomStream randomStream((unsigned int)seed);
+
+    // select two parents
+    unsigned int parent[2];
+    for (int i=0; i < 2; i++) {
+        
+        // if selection pressure is present
+        if (selector != NULL)
+            parent[i] = selector->select();
+        
+        else // no selection occurs, just select two parent randomly
+            parent[i] = static_cast<unsigned int>(genUniRand(0, params.populationSize));
+    }
+
+    size_t slot = 2*brood;
+    
+    // if crossOver is allowed 
+    if (params.crossOverOn) {
+        
+        // cross over parent genomes to make two kids
+        std::pair<nAgent, nAgent> kids = m_members[parent[0]]->crossOver(*m_members[parent[1]], firstID + (unsigned int)slot);
+        
+        // (moved: the genomes are not copied again)
+        children[slot] = new nAgent(std::move(kids.first));
+        children[slot + 1] = new nAgent(std::move(kids.second));
+        
+        children[slot]->mutate(); 
+        children[slot + 1]->mutate();
+    }
+    // if not by crossOver, generate via mutation from both the parents
+    else{
+        children[slot] = new nAgent(m_members[parent[0]]->inheriteViaMutation(firstID + (unsigned int)slot));
+        children[slot + 1] = new nAgent(m_members[parent[1]]->inheriteViaMutation(firstID + (unsigned int)slot + 1));
+    }
+    PROFILE_COUNT(COUNT_AGENTS_ALLOCATED, 2);
+    
+    children[slot]->applyDeletion();
+    children[slot + 1]->applyDeletion();
+    
+    children[slot]->applyInsertion();
+    children[slot + 1]->applyInsertion();
+    
+    // the brains are built once, from the final genomes
+    children[slot]->buildHMMs();
+    children[slot + 1]->buildHMMs();
 }
 
 
@@ -162,206 +305,82 @@ nPopulation nPopulation::reproduce(){
     // rank this population
     rank();
     
-    // make an empty population
+    // make an empty population (in the same lineage)
     nPopulation newPop;
+    newPop.m_ancestry = this->m_ancestry;
+    
+    // is selection pressure to be applied?
+    bool selectionPressure = underSelectionPressure();
     
     // if elitism is allowed (and selection pressure is to be applied)
-    if (m_id > static_cast<unsigned int>((selectionPressureFromGeneration/100.0)*maxGenerations) &&
-        m_id < static_cast<unsigned int>((selectionPressureUpToGeneration/100.0)*maxGenerations) &&
-        elitism){
-
-        // a new child from the elite mother
-        nAgent* eliteChild = new nAgent(*m_members[0]);
-        // elite child will have the exact genome of its mother
-        eliteChild->m_genome = m_members[0]->m_genome;
-        // build HMM units
-        eliteChild->buildHMMs();
+    if (selectionPressure && params.elitism){
+
+        // a new child from the elite mother (with her exact genome and brain)
+        nAgent* eliteChild = new nAgent(m_members[0]->inheriteAsClone());
+        PROFILE_COUNT(COUNT_AGENTS_ALLOCATED, 1);
         // insert in the new population
         newPop.addAgent(*eliteChild);
     }
 
     
-    // Roulette selection range
-    double fitnessSummed(0.0);
-    for (std::vector<nAgent*>::iterator it = m_members.begin(); 
-         it != m_members.end(); it++) {
-        // consider only those agents with fitness more than
-        // a fratction of the max fitness in the generation
-        if ((*it)->m_fitness >= purgeFraction*m_members[0]->m_fitness)
-            fitnessSummed += (*it)->m_fitness;
+    // selection of parents (set up once for the generation)
+    boost::scoped_ptr<nSelector> selector(nSelector::create());
+    if (selectionPressure)
+        selector->prepare(m_members);
+
+    // the rest of the generation in broods of two, made independently of each other
+    // (each its own random stream and numbered slots: the same children on any number of threads)
+    unsigned int missing = (params.populationSize > newPop.m_members.size()) ?
+                           params.populationSize - (unsigned int)newPop.m_members.size() : 0;
+    std::vector<nAgent*> children(2*((missing + 1)/2), (nAgent*)NULL);
+
+    if (!children.empty()) {
+        nRunContext& context = nRunContext::current();
+        unsigned int firstID = context.nextAgentIDs((unsigned int)children.size());
+
+        boost::function<void (size_t)> makeBrood =
+        boost::bind(&nPopulation::makeBrood, this, _1, boost::ref(children), firstID,
+                    selectionPressure ? selector.get() : (nSelector*)NULL, boost::ref(context));
+
+        if (context.getScheduler() != NULL)
+            context.getScheduler()->forEach(children.size()/2, makeBrood);
+        else
+            for (size_t i = 0; i < children.size()/2; i++)
+                makeBrood(i);
     }
 
-    while (newPop.m_members.size() < populationSize) {
-        
-        std::vector<int> parent;
+    // (born in the order of their slots)
+    for (std::vector<nAgent*>::iterator it = children.begin(); it != children.end(); it++)
+        newPop.addAgent(*(*it));
         
-        // select two parents (by Roulette selection)
-        for (int i=0; i < 2; i++) {
-            double total(m_members[0]->m_fitness);
-            unsigned int j(0);
+    {
+        PROFILE_PHASE(PHASE_CLEAN_LINEAGE);
         
-            // if selection pressure is present
-            if (m_id > static_cast<unsigned int>((selectionPressureFromGeneration/100.0)*maxGenerations) &&
-                m_id < static_cast<unsigned int>((selectionPressureUpToGeneration/100.0)*maxGenerations) ) {
-                
-                // generate a number (drop a niddle) between 0, sum[row]
-                double dropper = genUniRand(0, fitnessSummed);
-                
-                while (dropper > total){
-                    j++;
-                    total += m_members[j]->m_fitness;
-                }
+        // retire the old population (to the ancestry, which frees the agents and drops the "impotent" lineage)
+        for (std::vector<nAgent*>::iterator it = m_members.begin();
+             it != m_members.end(); it++) {
+            if (m_ancestry != NULL)
+                m_ancestry->retire(*(*it));
+            else {
+                delete *it;
+                PROFILE_COUNT(COUNT_AGENTS_FREED, 1);
             }
-            
-            else // no selection occurs, just select two parent randomly
-                j = static_cast<unsigned int>(genUniRand(0, populationSize));
-            
-            parent.push_back(j);
         }
+        m_members.clear();
         
-        // if crossOver is allowed 
-        if (crossOverOn) {
-            
-            // cross over parent genomes to make two kids
-            
-            std::pair<nAgent, nAgent> kids = m_members[parent[0]]->crossOver(*m_members[parent[1]]);
-            
-            nAgent* child1 = new nAgent(kids.first);
-            nAgent* child2 = new nAgent(kids.second);
+        // without an ancestry, there is no lineage to keep
+        if (m_ancestry == NULL)
+            for (std::vector<nAgent*>::iterator it = newPop.m_members.begin();
+                 it != newPop.m_members.end(); it++)
+                (*it)->m_parents.clear();
         
-            child1->mutate(); 
-            child2->mutate();
-            
-            child1->applyDeletion();
-            child2->applyDeletion();
-            
-            child1->applyInsertion();
-            child2->applyInsertion();
-           
-            child1->buildHMMs();
-            child2->buildHMMs();
-            
-            newPop.addAgent(*child1);
-            newPop.addAgent(*child2);
-        }
-        // if not by crossOver, generate via mutation from both the parents
-        else{
-            nAgent* child1 = new nAgent(m_members[parent[0]]->inheriteViaMutation());
-            nAgent* child2 = new nAgent(m_members[parent[1]]->inheriteViaMutation());
-            
-            child1->applyDeletion();
-            child2->applyDeletion();
-            
-            child1->applyInsertion();
-            child2->applyInsertion();
-            
-            child1->buildHMMs();
-            child2->buildHMMs();
-            
-            newPop.addAgent(*child1);
-            newPop.addAgent(*child2);
-        }
-    }
+        // bring the new population in size
+        newPop.manageSize();
         
-    // retire the old population
-    for (std::vector<nAgent*>::iterator it = m_members.begin();
-         it != m_members.end(); it++) {
-        (*it)->retire();
+        // resolve the line of descent up to this generation
+        if (m_ancestry != NULL)
+            m_ancestry->coalesce(m_id);
     }
     
-    // bring the new population in size
-    newPop.manageSize();
-    
-    // clean the "impotent" lineage
-    this->cleanLineage();
-    
-    // set parent population
-    newPop.m_parentPopulation = this;
-    
-    // set child LOD output stream to parent's
-    newPop.m_lodOutput = this->m_lodOutput;
-    
-    // set child analysis output stream to parent's
-    newPop.m_analysisOutput = this->m_analysisOutput;
-    
     return newPop;
 }
-
-
-void nPopulation::cleanLineage(){
-            
-    // remove those "dead" agents, which do not have any progeny left
-    for (std::vector<nAgent*>::iterator it = m_members.begin();
-         it != m_members.end(); it++)
-        if ( (!(*it)->m_alive) && ((*it)->m_lineageSize == 0) ){
-            removeAgent(*(*it));
-            it--;
-        }
-    
-    // propagate this down the evolution
-    if (m_parentPopulation != NULL){
-        m_parentPopulation->cleanLineage();
-        
-        // if the previous (cleaned up to now) generation 
-        // has only one member left
-        if(m_parentPopulation->m_members.size() == 1){
-        
-            // remove pointers from "this" generation to that "single" parent
-            for (std::vector<nAgent*>::iterator it = m_members.begin();
-                 it != m_members.end(); it++)
-                (*it)->m_parents.clear();
-            
-            // store the "single" parent to the LOD file
-            *m_lodOutput << "# Gen no. " << m_parentPopulation->m_id 
-            << " (agent fitness = " << m_parentPopulation->m_members.back()->m_fitness 
-            << "):" << std::endl;
-            m_parentPopulation->m_members.back()->printGenome(*m_lodOutput);
-            
-            // perform knockout analysis for the "single" parent
-            nAgent* origPlayer = m_game->getPlayer();
-            m_parentPopulation->m_members.back()->m_alive = true;
-            m_game->updatePlayer(*m_parentPopulation->m_members.back());
-            *m_game->m_knockoutOutput << "# Gen no. " << m_parentPopulation->m_id << ":" << std::endl;
-            m_game->profilePlayerKnockout();
-            m_parentPopulation->m_members.back()->m_alive = false;
-            m_game->updatePlayer(*origPlayer);
-            
-            // perform Phi, etc analysis after an interval
-            if (m_parentPopulation->m_id % analysisInterval == 0){
-                *m_analysisOutput << m_parentPopulation->m_id << "\t";
-                nAnalyzer analyzer(m_parentPopulation->m_members.back()->m_id,
-                                   m_parentPopulation->m_members.back()->m_genome, 
-                                   m_parentPopulation->m_members.back()->m_fitness,
-                                   *m_analysisOutput);
-                analyzer.setRequirements("all");
-                analyzer.run();
-                //                m_parentPopulation->m_members.back()->analyze(false, m_analysisOutput);
-                // boost::thread analysisThread(&nAnalyzer::analyze, &analyzer, false);
-               // analysisThread.join();
-            }
-            
-            // remove the "single" parent from the generation
-            m_parentPopulation->removeAgent(*m_parentPopulation->m_members.back());
-            // "this" generation does not point to any parent population counter 
-            m_parentPopulation = NULL;
-        }
-    }
-}
-
-void nPopulation::setLODoutputStream(std::ostream& output){ 
-    // this LOD output stream
-    m_lodOutput = &output;
-    
-    // propagate down the parent
-    if (m_parentPopulation != NULL) 
-        m_parentPopulation->m_lodOutput = m_lodOutput;
-}
-
-void nPopulation::setAnalysisOutputStream(std::ostream& output){ 
-    // this analysis output stream
-    m_analysisOutput = &output;
-    
-    // propagate down the parent
-    if (m_parentPopulation != NULL) 
-        m_parentPopulation->setAnalysisOutputStream(*m_analysisOutput);
-}
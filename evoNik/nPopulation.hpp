@@ -12,7 +12,9 @@
 #include "constants.hpp"
 #include "nAgent.hpp"
 #include "nGame.hpp"
-#include "nAnalyzer.hpp"
+#include "nAncestry.hpp"
+
+class nSelector;
 
 class nPopulation{
 public:
@@ -20,52 +22,95 @@ public:
     
     // constructor for empty population
     nPopulation(): 
-    m_id(generationID++), 
-    m_lodOutput(&std::cout),
-    m_analysisOutput(&std::cout){
-        m_parentPopulation = NULL;
-        m_ranked = false;
+    m_id(nRunContext::current().nextGenerationID()), 
+    m_ancestry(NULL){
+        m_ranked = m_statisticsValid = m_evaluated = false;
+        m_gamesPlayed = 0;
     }
 
     // constructor with a "master" agent
     nPopulation(nAgent& a):
-    m_id(generationID++), 
-    m_lodOutput(&std::cout),
-    m_analysisOutput(&std::cout){
-        m_parentPopulation = NULL;
+    m_id(nRunContext::current().nextGenerationID()), 
+    m_ancestry(NULL){
+        m_ranked = m_statisticsValid = m_evaluated = false;
+        m_gamesPlayed = 0;
         m_members.push_back(&a);
         populate();  
     }
     
     // constructor with a list of agents
-    nPopulation(std::vector<nAgent*> members): 
-    m_id(generationID++),
+    nPopulation(const std::vector<nAgent*>& members): 
+    m_id(nRunContext::current().nextGenerationID()),
     m_members(members),
-    m_lodOutput(&std::cout),
-    m_analysisOutput(&std::cout){
-        m_parentPopulation = NULL;
-        m_ranked = false;
+    m_ancestry(NULL){
+        m_ranked = m_statisticsValid = m_evaluated = false;
+        m_gamesPlayed = 0;
     }
     
     // copy constructor
     nPopulation(const nPopulation &o):
     m_id(o.m_id), 
-    m_parentPopulation(o.m_parentPopulation),
     m_members(o.m_members),
     m_ranked(o.m_ranked),
-    m_lodOutput(o.m_lodOutput),
-    m_analysisOutput(o.m_analysisOutput){         
+    m_statisticsValid(o.m_statisticsValid),
+    m_evaluated(o.m_evaluated),
+    m_minFitness(o.m_minFitness),
+    m_maxFitness(o.m_maxFitness),
+    m_averageFitness(o.m_averageFitness),
+    m_elite(o.m_elite),
+    m_gamesPlayed(o.m_gamesPlayed),
+    m_ancestry(o.m_ancestry){         
     
     }
 
+    // move constructor (takes over the members)
+    nPopulation(nPopulation &&o):
+    m_id(o.m_id), 
+    m_members(std::move(o.m_members)),
+    m_ranked(o.m_ranked),
+    m_statisticsValid(o.m_statisticsValid),
+    m_evaluated(o.m_evaluated),
+    m_minFitness(o.m_minFitness),
+    m_maxFitness(o.m_maxFitness),
+    m_averageFitness(o.m_averageFitness),
+    m_elite(o.m_elite),
+    m_gamesPlayed(o.m_gamesPlayed),
+    m_ancestry(o.m_ancestry){
+        o.m_members.clear();
+    }
+
     // assignment operator
-    nPopulation& operator = (const nPopulation o){
+    nPopulation& operator = (const nPopulation& o){
         m_id = o.m_id;
-        m_parentPopulation = o.m_parentPopulation;
         m_members = o.m_members;
         m_ranked = o.m_ranked;
-        m_lodOutput = o.m_lodOutput;
-        m_analysisOutput = o.m_analysisOutput;
+        m_statisticsValid = o.m_statisticsValid;
+        m_evaluated = o.m_evaluated;
+        m_minFitness = o.m_minFitness;
+        m_maxFitness = o.m_maxFitness;
+        m_averageFitness = o.m_averageFitness;
+        m_elite = o.m_elite;
+        m_gamesPlayed = o.m_gamesPlayed;
+        m_ancestry = o.m_ancestry;
+        return *this;
+    }
+    
+    // move assignment operator
+    nPopulation& operator = (nPopulation&& o){
+        if (this == &o)
+            return *this;
+        m_members.swap(o.m_members);
+        o.m_members.clear();
+        m_id = o.m_id;
+        m_ranked = o.m_ranked;
+        m_statisticsValid = o.m_statisticsValid;
+        m_evaluated = o.m_evaluated;
+        m_minFitness = o.m_minFitness;
+        m_maxFitness = o.m_maxFitness;
+        m_averageFitness = o.m_averageFitness;
+        m_elite = o.m_elite;
+        m_gamesPlayed = o.m_gamesPlayed;
+        m_ancestry = o.m_ancestry;
         return *this;
     }
     
@@ -78,27 +123,31 @@ public:
     // get generation id
     unsigned int getGenerationID(void)                   { return m_id; }
     // get the members
-    std::vector<nAgent*> getMembers(void)                { return m_members; }
-    // set parent population
-    void setParentPopulation(nPopulation& pop)           { m_parentPopulation = &pop; }
+    const std::vector<nAgent*>& getMembers(void) const   { return m_members; }
     // populate
-    void populate(unsigned int size = populationSize);
+    void populate(unsigned int size = params.populationSize);
     // add a given agent in the population
     void addAgent(nAgent& a);
     // remove a given agent from the population
     void removeAgent(nAgent& a);
     // bring size to the limit set
     void manageSize(void);
-    // generate the next generation
+    // generate the next generation (moved out, members and all)
     nPopulation reproduce(void);
     // retire
     bool retire(void);
     // evaluate
     void evaluate(nGame& game);
+    // number of games played in the last evaluation
+    unsigned int getGamesPlayed(void)                    { return m_gamesPlayed; }
     // rank the individuals according to fitnesses
     void rank(void);
     // get the individual with highest fitness
     nAgent* getElite(void);
+    // get the count fittest individuals (the fittest first)
+    std::vector<nAgent*> getFittest(unsigned int count);
+    // replace the last born members by newcomers with the given genomes (from the given origins)
+    void immigrate(const std::vector<nGenome>& genomes, const std::vector<nAgent::origin>& origins);
     // get average fitness of the generation
     double getAverageFitness(void);
     // get maximum (elite) fitness
@@ -107,33 +156,31 @@ public:
     double getMinFitness(void);
     // print population (agent id's)
     void printPopulation(std::ostream& fout = std::cout);
-    // clean the lineage
-    void cleanLineage();
-    // set lod data stream
-    void setLODoutputStream(std::ostream& output); 
-    // set analysis data stream
-    void setAnalysisOutputStream(std::ostream& output);
+    // set the ancestry (lineage bookkeeping) of the members
+    void setAncestry(nAncestry& ancestry)                { m_ancestry = &ancestry; }
     
     
 private:
-    // master id
-    static unsigned int generationID;
-    
     // id for this generation
     unsigned int m_id;
-    // parent population
-    nPopulation* m_parentPopulation;
     // members of population
     std::vector<nAgent*> m_members;
-    // whether ranked (according to ascending fitness)
+    // whether ranked (according to descending fitness), false when members or fitnesses changed
     bool m_ranked;
+    // whether the statistics below are up to date
+    bool m_statisticsValid;
+    // whether the members were evaluated (have fitnesses)
+    bool m_evaluated;
+    // fitness statistics (one pass over the members)
+    double m_minFitness, m_maxFitness, m_averageFitness;
+    // the fittest member
+    nAgent* m_elite;
+    // games played in the evaluation
+    unsigned int m_gamesPlayed;
     // game for evaluation and knockout profiling of the population
     nGame* m_game;
-    
-    // LOD data output stream
-    std::ostream* m_lodOutput;
-    // analysis data output stream
-    std::ostream* m_analysisOutput;
+    // ancestry the members are registered with (NULL: no lineage is kept)
+    nAncestry* m_ancestry;
     
     
     // for ranking fitnesses (by pointers to agents)
@@ -142,6 +189,23 @@ private:
             return *a1 < *a2;
         }
     };
+    // the fitter first
+    struct fitterThan{
+        bool operator ()(const nAgent* a1, const nAgent* a2){
+            return *a2 < *a1;
+        }
+    };
+    
+    // is this generation selected (within the selection pressure window)?
+    bool underSelectionPressure(void);
+    // compute the fitness statistics (if outdated)
+    void updateStatistics(void);
+    // make the children of a brood (parents selected, varied and built) into their slots
+    // 2*brood and 2*brood + 1, numbered firstID on (selector NULL: no selection pressure)
+    void makeBrood(size_t brood, std::vector<nAgent*>& children, unsigned int firstID,
+                   nSelector* selector, nRunContext& context);
+    // keep the fittest members only
+    void keepFittest(unsigned int size);
     
 };
 
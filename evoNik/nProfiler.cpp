@@ -0,0 +1,71 @@
+//
+//  nProfiler.cpp
+//  evoNik
+//
+
+#include "nProfiler.hpp"
+
+#ifndef EVONIK_NO_PROFILING
+
+nProfiler::nProfiler()
+: m_activePhase(PHASE_OTHER),
+m_phaseStart(clock::now()),
+m_generationStart(m_phaseStart){
+
+    for (unsigned int i = 0; i < PHASE_COUNT; i++)
+        m_phaseTimes[i] = 0;
+    for (unsigned int i = 0; i < COUNT_COUNT; i++)
+        m_counters[i] = 0;
+}
+
+
+nProfiler::phase nProfiler::switchPhase(phase p){
+
+    clock::time_point now = clock::now();
+    m_phaseTimes[m_activePhase] += boost::chrono::duration<double>(now - m_phaseStart).count();
+    m_phaseStart = now;
+
+    phase previous = m_activePhase;
+    m_activePhase = p;
+    return previous;
+}
+
+
+void nProfiler::printHeader(std::ostream& fout){
+    fout << "# gen\twall(s)\tmaze(s)\tevaluate(s)\treproduce(s)\tcleanLineage(s)\toutput(s)\tmigrate(s)\tother(s)"
+    << "\tbrainSteps\tskippedSteps\tagentsAllocated\tagentsFreed\tliveGenerations\tlineageDepth\tlineageAgents" << std::endl;
+}
+
+
+void nProfiler::print(std::ostream& fout, unsigned int genID, unsigned int liveGenerations,
+                      unsigned int lineageDepth, unsigned int lineageAgents){
+
+    // close the books of this generation
+    switchPhase(m_activePhase);
+    double wallTime = boost::chrono::duration<double>(m_phaseStart - m_generationStart).count();
+
+    fout << genID << "\t" << wallTime << "\t"
+    << m_phaseTimes[PHASE_MAZE] << "\t"
+    << m_phaseTimes[PHASE_EVALUATE] << "\t"
+    << m_phaseTimes[PHASE_REPRODUCE] << "\t"
+    << m_phaseTimes[PHASE_CLEAN_LINEAGE] << "\t"
+    << m_phaseTimes[PHASE_OUTPUT] << "\t"
+    << m_phaseTimes[PHASE_MIGRATE] << "\t"
+    << m_phaseTimes[PHASE_OTHER] << "\t"
+    << m_counters[COUNT_BRAIN_STEPS] << "\t"
+    << m_counters[COUNT_SKIPPED_STEPS] << "\t"
+    << m_counters[COUNT_AGENTS_ALLOCATED] << "\t"
+    << m_counters[COUNT_AGENTS_FREED] << "\t"
+    << liveGenerations << "\t"
+    << lineageDepth << "\t"
+    << lineageAgents << std::endl;
+
+    // start the next generation
+    for (unsigned int i = 0; i < PHASE_COUNT; i++)
+        m_phaseTimes[i] = 0;
+    for (unsigned int i = 0; i < COUNT_COUNT; i++)
+        m_counters[i] = 0;
+    m_generationStart = m_phaseStart;
+}
+
+#endif
@@ -0,0 +1,111 @@
+//
+//  nProfiler.hpp
+//  evoNik
+//
+//  Per-generation instrumentation of a run: wall time spent in each
+//  phase of a generation (exclusive of nested phases) and counters of
+//  the work done. Every run context owns one profiler; the run writes
+//  and resets it once per generation (perfData.txt).
+//
+//  Compiling with EVONIK_NO_PROFILING (b2 define=EVONIK_NO_PROFILING)
+//  removes the profiler and all its probes.
+//
+
+#ifndef evoNik_nProfiler_hpp
+#define evoNik_nProfiler_hpp
+
+#ifndef EVONIK_NO_PROFILING
+
+#include <iostream>
+
+#include <boost/atomic.hpp>
+#include <boost/chrono.hpp>
+
+class nProfiler{
+public:
+
+    // timed phases of a generation
+    enum phase{
+        PHASE_OTHER = 0,            // anything outside the phases below
+        PHASE_MAZE,                 // maze and fitness landscape rebuilds
+        PHASE_EVALUATE,             // fitness evaluation
+        PHASE_REPRODUCE,            // selection and variation
+        PHASE_CLEAN_LINEAGE,        // retiring to the ancestry (LOD, knockout, in place analyses)
+        PHASE_OUTPUT,               // progress and analysis output
+        PHASE_MIGRATE,              // exchange with the other islands (incl. waiting for them)
+        PHASE_COUNT
+    };
+
+    // counted events
+    enum counter{
+        COUNT_BRAIN_STEPS = 0,      // brain updates during fitness evaluation
+        COUNT_SKIPPED_STEPS,        // game steps fast-forwarded over repeating cycles
+        COUNT_AGENTS_ALLOCATED,     // agents created on the heap
+        COUNT_AGENTS_FREED,         // agents deleted
+        COUNT_COUNT
+    };
+
+    // constructor
+    nProfiler();
+
+    // member functions
+    // add to a counter
+    void count(counter c, unsigned long n = 1)                  { m_counters[c] += n; }
+    // write the header line of the per-generation records
+    static void printHeader(std::ostream& fout);
+    // write the record of a generation and start a new one
+    void print(std::ostream& fout, unsigned int genID, unsigned int liveGenerations,
+               unsigned int lineageDepth, unsigned int lineageAgents);
+
+    // scoped timing of a phase (nested phases are charged to themselves only)
+    class scopedPhase{
+    public:
+        scopedPhase(nProfiler& profiler, phase p)
+        : m_profiler(profiler),
+        m_previous(profiler.switchPhase(p)){
+        }
+        ~scopedPhase(){
+            m_profiler.switchPhase(m_previous);
+        }
+    private:
+        nProfiler& m_profiler;
+        phase m_previous;
+
+        scopedPhase(const scopedPhase&);
+        scopedPhase& operator = (const scopedPhase&);
+    };
+
+private:
+    typedef boost::chrono::steady_clock clock;
+
+    // time (s) per phase in the current generation
+    double m_phaseTimes[PHASE_COUNT];
+    // counters of the current generation
+    boost::atomic<unsigned long> m_counters[COUNT_COUNT];
+    // the phase running now and since when
+    phase m_activePhase;
+    clock::time_point m_phaseStart;
+    // start of the current generation
+    clock::time_point m_generationStart;
+
+    // charge the time so far to the active phase and activate p (returns the previous)
+    phase switchPhase(phase p);
+
+    // not copyable
+    nProfiler(const nProfiler&);
+    nProfiler& operator = (const nProfiler&);
+};
+
+
+// probes (used through these, so that they compile away)
+#define PROFILE_PHASE(p)            nProfiler::scopedPhase profiledPhase(nRunContext::current().getProfiler(), nProfiler::p)
+#define PROFILE_COUNT(c, n)         nRunContext::current().getProfiler().count(nProfiler::c, (n))
+
+#else
+
+#define PROFILE_PHASE(p)
+#define PROFILE_COUNT(c, n)         ((void)(n))
+
+#endif
+
+#endif
@@ -9,6 +9,11 @@
 #include <iostream>
 
 #include "nRun.hpp"
+#include "nArchipelago.hpp"
+
+// header of the analysis file
+static const char* analysisHeader =
+"# gen\tagentID\tfitness\tPhiMC\tMC\tMCnodes\tMIPevals\tMItot\tMIpred\tgenNumSite\tgenLenUncompr\tgenLenCompr\treused";
 
 void nRun::init(){
     
@@ -44,18 +49,51 @@ void nRun::init(){
     m_knockoutFile.open((m_thisRunDirectory.string()+"/knockout.txt").c_str(), std::ios::out | std::ios::app);
     m_analysisFile.open((m_thisRunDirectory.string()+"/analysisData.txt").c_str(), std::ios::out | std::ios::app);
     m_progressFile.open((m_thisRunDirectory.string()+"/progressData.txt").c_str(), std::ios::out | std::ios::app);
+    m_parameterFile.open((m_thisRunDirectory.string()+"/parameters.txt").c_str(), std::ios::out | std::ios::trunc);
+#ifndef EVONIK_NO_PROFILING
+    m_perfFile.open((m_thisRunDirectory.string()+"/perfData.txt").c_str(), std::ios::out | std::ios::app);
+#endif
+    
+    // record the parameters of this run
+    m_parameterFile << "# run " << m_id << " (seed = " << m_seed << ")" << std::endl;
+    params.print(m_parameterFile);
+    m_parameterFile.close();
+    
+    // ancestors are written as edits between keyframes
+    m_lod.reset(new nLOD(m_lodFile));
+    
+    // analyses are queued (and possibly off-loaded), brains analysed before are not analysed again
+    if (params.cacheAnalyses)
+        m_analysisCache.reset(new nAnalysisCache(m_thisRunDirectory.string()+"/analysisCache.txt"));
+    m_analysisQueue.reset(new nAnalysisQueue(m_analysisFile, m_context.getScheduler(), m_analysisCache.get()));
     
     
     // header in analysis file
-    m_analysisFile << "# gen\tagentID\tfitness\tPhiMC\tMC\tMCnodes\tMItot\tMIpred\tgenNumSite\tgenLenUncompr\tgenLenCompr" << std::endl;
+    m_analysisFile << analysisHeader << std::endl;
     
     // header in progress file
-    m_progressFile << "# gen \t ave. fitness\tMax. fitness" << std::endl;
+    m_progressFile << "# run " << m_id << " (seed = " << m_seed << ")" << std::endl;
+    m_progressFile << "# gen \t ave. fitness\tMax. fitness\tgames/agent\tcache hit rate"
+    << (params.steadyState ? "\tbirths/s" : "") << std::endl;
     
+#ifndef EVONIK_NO_PROFILING
+    // header in performance file
+    m_perfFile << "# run " << m_id << " (seed = " << m_seed << ")" << std::endl;
+    nProfiler::printHeader(m_perfFile);
+#endif
 }
 
 void nRun::go(){
     
+    if (params.steadyState) {
+        goSteadyState();
+        return;
+    }
+    
+    // work within this run's id counters and random stream
+    nRunContext::scope contextScope(m_context);
+    nRandomStream randomStream(m_seed);
+    
     // einstein
 //    std::fstream einsteinBrain;
 //    einsteinBrain.open("einstein.txt", std::ios::in);
@@ -66,45 +104,86 @@ void nRun::go(){
     std::vector<nPopulation*> generations;
     
     // maze 
-    nMaze runMaze(evaluationTime + 10, 15);
+    nMaze runMaze(params.evaluationTime + 10, 15);
     
     // game
     nGame runGame(runMaze);
     runGame.setKnockoutStream(m_knockoutFile);
+    
+    // evaluations shared by agents with the same brain
+    nFitnessCache fitnessCache;
+    runGame.setFitnessCache(fitnessCache);
+    m_game = &runGame;
+    
+    // resolved ancestors go to the LOD, knockout and analysis
+    m_ancestry.setEntryHandler(boost::bind(&nRun::recordAncestor, this, _1, _2));
        
     // initial population
     nPopulation* initPopulation = new nPopulation;
-    initPopulation->setLODoutputStream(m_lodFile);
-    initPopulation->setAnalysisOutputStream(m_analysisFile);
+    initPopulation->setAncestry(m_ancestry);
     initPopulation->populate();
     
     // add to generation
     generations.push_back(initPopulation);
     
     // iterate over generations
-    for (unsigned int gen = 0; gen < maxGenerations + 10; gen++) {
+    for (unsigned int gen = 0; gen < params.maxGenerations + 10; gen++) {
         
         // update the test maze after every 100 generations
         if (gen % 100 == 0 && gen != 0) {
+            PROFILE_PHASE(PHASE_MAZE);
             runMaze.create();
             runGame.updatePlayGround(runMaze);
+            fitnessCache.clear();
         }
 
-        generations.back()->evaluate(runGame);
-          
-        m_progressFile << generations.back()->getGenerationID() << "\t"
-        << generations.back()->getAverageFitness() << "\t"
-        << generations.back()->getMaxFitness() << std::endl;
+        {
+            PROFILE_PHASE(PHASE_EVALUATE);
+            generations.back()->evaluate(runGame);
+        }
+        
+#ifndef EVONIK_NO_PROFILING
+        unsigned int genID = generations.back()->getGenerationID();
+#endif
+        
+        {
+            PROFILE_PHASE(PHASE_OUTPUT);
+            m_progressFile << generations.back()->getGenerationID() << "\t"
+            << generations.back()->getAverageFitness() << "\t"
+            << generations.back()->getMaxFitness() << "\t"
+            << (double)generations.back()->getGamesPlayed() / generations.back()->getMembers().size() << "\t"
+            << fitnessCache.getHitRate() << std::endl;
+            fitnessCache.resetHitRate();
+            
+            if (!params.suppressMessages)
+                std::cout << "Gen. no. " << generations.back()->getGenerationID()
+                << "\tAve. fitness = " << generations.back()->getAverageFitness() 
+                << "\tMax. fitness = " << generations.back()->getMaxFitness() << std::endl;
+        }
         
-        if (!suppressMessages)
-            std::cout << "Gen. no. " << generations.back()->getGenerationID()
-            << "\tAve. fitness = " << generations.back()->getAverageFitness() 
-            << "\tMax. fitness = " << generations.back()->getMaxFitness() << std::endl;
+        // exchange the fittest with the other islands
+        std::vector<nGenome> immigrants;
+        std::vector<nAgent::origin> origins;
+        if (m_archipelago != NULL) {
+            PROFILE_PHASE(PHASE_MIGRATE);
+            m_archipelago->report(m_island, generations.back()->getGenerationID(),
+                                  generations.back()->getAverageFitness(), generations.back()->getMaxFitness());
+            if (gen % params.migrationInterval == 0 && gen != 0)
+                m_archipelago->exchange(m_island, *generations.back(), immigrants, origins);
+        }
+        
+        {
+            PROFILE_PHASE(PHASE_REPRODUCE);
+            nPopulation* newPop = new nPopulation(generations.back()->reproduce());
+            newPop->immigrate(immigrants, origins);
+            generations.push_back(newPop);
+        }
         
-        nPopulation* newPop = new nPopulation(generations.back()->reproduce());
-        newPop->setLODoutputStream(m_lodFile);
-        newPop->setAnalysisOutputStream(m_analysisFile);
-        generations.push_back(newPop);
+        {
+            // write out finished analyses
+            PROFILE_PHASE(PHASE_OUTPUT);
+            m_analysisQueue->flush();
+        }
         
         // clean up empty generations
         if (generations[0]->getMembers().size() == 0) {
@@ -112,55 +191,344 @@ void nRun::go(){
             generations.erase(generations.begin());
         }
         
+#ifndef EVONIK_NO_PROFILING
+        // lineage held back (ancestors not yet resolved into the LOD)
+        m_context.getProfiler().print(m_perfFile, genID, (unsigned int)generations.size(),
+                                      m_ancestry.getDepth(), m_ancestry.getSize());
+#endif
     }
     
     // complete the LOD and knockout and analysis
     // (the latter generations have more than one species and hence not removed)
-    generations.back()->rank();
     this->dumpRemainingLODandKnockout(generations.back()->getGenerationID(),
-                                      *(generations.back()->getMembers())[0],
-                                      runGame);
+                                      *generations.back()->getElite());
+    
+    // the agents themselves are freed with the ancestry
+    for (size_t i = 0; i < generations.size(); i++)
+        delete generations[i];
+    m_game = NULL;
+}
+
+
+void nRun::goSteadyState(){
+    
+    // work within this run's id counters and random stream
+    nRunContext::scope contextScope(m_context);
+    nRandomStream randomStream(m_seed);
+    
+    // maze and game (the breeders share the maze, in games of their own)
+    m_maze.reset(new nMaze(params.evaluationTime + 10, 15));
+    nGame runGame(*m_maze);
+    runGame.setKnockoutStream(m_knockoutFile);
+    nFitnessCache fitnessCache;
+    runGame.setFitnessCache(fitnessCache);
+    m_game = &runGame;
+    
+    // resolved ancestors go to the LOD, knockout and analysis
+    m_ancestry.setEntryHandler(boost::bind(&nRun::recordAncestor, this, _1, _2));
+    
+    // the founders, evaluated as a generation
+    nPopulation founders;
+    founders.setAncestry(m_ancestry);
+    founders.populate();
+    founders.evaluate(runGame);
+    
+    m_progressFile << founders.getGenerationID() << "\t"
+    << founders.getAverageFitness() << "\t"
+    << founders.getMaxFitness() << "\t"
+    << (double)founders.getGamesPlayed() / founders.getMembers().size() << "\t"
+    << fitnessCache.getHitRate() << "\t" << 0 << std::endl;
+    
+    // as many births as generations would be made
+    nSteadyState population(founders.getMembers(), m_ancestry,
+                            (unsigned long)(params.maxGenerations + 10)*params.populationSize);
+    population.setGenerationHandler(boost::bind(&nRun::snapshotGeneration, this, &population, _1));
+    
+    // (while breeding, LOD entries are resolved with the population locked, and recorded out of the lock)
+    m_ancestry.setEntryHandler(boost::bind(&nRun::deferAncestor, this, _1, _2));
+    m_mazeID = m_maze->getID();
+    
+    boost::function<void (size_t)> breeder = boost::bind(&nRun::breed, this, boost::ref(population), _1);
+    if (m_context.getScheduler() != NULL)
+        m_context.getScheduler()->forEach(m_context.getScheduler()->getNumThreads(), breeder);
+    else
+        breeder(0);
+    
+    // the generations not recorded by the breeders
+    recordGenerations(true);
+    m_ancestry.setEntryHandler(boost::bind(&nRun::recordAncestor, this, _1, _2));
+    
+    // complete the LOD and knockout and analysis
+    this->dumpRemainingLODandKnockout(population.getElite()->m_generation, *population.getElite());
+    
+    // the agents themselves are freed with the ancestry
+    m_game = NULL;
+    m_maze.reset();
+}
+
+
+void nRun::breed(nSteadyState& population, size_t breeder){
+    
+    // (may be run by a worker thread) within this run, on a random stream of its own
+    nRunContext::scope contextScope(m_context);
+    size_t seed = m_seed;
+    boost::hash_combine(seed, breeder);
+    nRandomStream randomStream((unsigned int)seed);
+    
+    // the maze of the run (picked up again as the run makes a new one), in a game of its own
+    boost::shared_ptr<nMaze> maze;
+    boost::scoped_ptr<nGame> game;
+    nFitnessCache fitnessCache;
+    
+    std::vector<nAgent*> newborns;
+    while (population.conceive(newborns)) {
+        for (std::vector<nAgent*>::iterator it = newborns.begin(); it != newborns.end(); it++) {
+            nAgent* newborn = *it;
+            
+            newborn->mutate();
+            newborn->applyDeletion();
+            newborn->applyInsertion();
+            newborn->buildHMMs();
+            
+            if (!game || maze->getID() != m_mazeID) {
+                boost::lock_guard<boost::mutex> lock(m_gameMutex);
+                maze = m_maze;
+                game.reset(new nGame(*m_game));
+                game->usePlayGround(*maze);
+                game->setFitnessCache(fitnessCache);
+            }
+            
+            fitnessCache.resetHitRate();
+            unsigned int gamesPlayed = game->evaluate(*newborn);
+            population.insert(*newborn, gamesPlayed, fitnessCache.getLookups(), fitnessCache.getHits());
+            
+            // (out of the population lock)
+            recordGenerations();
+        }
+    }
+}
+
+
+void nRun::snapshotGeneration(nSteadyState* population, unsigned int gen){
+    
+    generationRecord record;
+    record.gen = gen;
+    record.averageFitness = population->getAverageFitness();
+    record.maxFitness = population->getMaxFitness();
+    record.gamesPerBirth = population->getGamesPerBirth();
+    record.cacheHitRate = population->getCacheHitRate();
+    record.birthRate = population->getBirthRate();
+    
+    // resolve the line of descent (up to the ancestors still alive)
+    m_ancestry.coalesce(population->getLiveGeneration());
+    record.entries.swap(m_deferredEntries);
+    record.ancestryDepth = m_ancestry.getDepth();
+    record.ancestrySize = m_ancestry.getSize();
+    
+    boost::lock_guard<boost::mutex> lock(m_pendingMutex);
+    m_pendingGenerations.push_back(record);
+}
+
+
+void nRun::deferAncestor(unsigned int genID, nAgent& a){
+    
+    // genome and brain, and what the knockout profile starts from
+    boost::shared_ptr<nAgent> ancestor(new nAgent(static_cast<const nAgent&>(a)));
+    ancestor->m_fitness = a.m_fitness;
+    ancestor->m_curState = a.m_curState;
+    ancestor->m_curHighState = a.m_curHighState;
+    ancestor->m_prevPosition = a.m_prevPosition;
+    ancestor->m_alive = a.m_alive;
+    PROFILE_COUNT(COUNT_AGENTS_ALLOCATED, 1);
+    
+    m_deferredEntries.push_back(std::make_pair(genID, ancestor));
+}
+
+
+void nRun::recordGenerations(bool wait){
+    
+    // one breeder records, the others go on breeding
+    boost::unique_lock<boost::mutex> recorder(m_recorderMutex, boost::defer_lock);
+    if (wait)
+        recorder.lock();
+    else if (!recorder.try_lock())
+        return;
+    
+    while (true) {
+        generationRecord record;
+        {
+            boost::lock_guard<boost::mutex> lock(m_pendingMutex);
+            if (m_pendingGenerations.empty())
+                return;
+            record = m_pendingGenerations.front();
+            m_pendingGenerations.pop_front();
+        }
+        
+        // (no breeder copies the game meanwhile)
+        boost::lock_guard<boost::mutex> lock(m_gameMutex);
+        
+        m_progressFile << record.gen << "\t"
+        << record.averageFitness << "\t"
+        << record.maxFitness << "\t"
+        << record.gamesPerBirth << "\t"
+        << record.cacheHitRate << "\t"
+        << record.birthRate << std::endl;
+        
+        if (!params.suppressMessages)
+            std::cout << "Gen. no. " << record.gen
+            << "\tAve. fitness = " << record.averageFitness
+            << "\tMax. fitness = " << record.maxFitness
+            << "\tBirths/s = " << record.birthRate << std::endl;
+        
+        // the LOD entries resolved with it
+        for (size_t i = 0; i < record.entries.size(); i++) {
+            recordAncestor(record.entries[i].first, *record.entries[i].second);
+            PROFILE_COUNT(COUNT_AGENTS_FREED, 1);
+        }
+        
+        // write out finished analyses
+        m_analysisQueue->flush();
+        
+        // update the test maze after every 100 generations
+        // (a new maze: the breeders play in the old one until they pick this one up)
+        if (record.gen % 100 == 0) {
+            boost::shared_ptr<nMaze> maze(new nMaze(params.evaluationTime + 10, 15));
+            m_game->updatePlayGround(*maze);
+            m_game->getFitnessCache()->clear();
+            m_maze = maze;
+            m_mazeID = maze->getID();
+        }
+        
+#ifndef EVONIK_NO_PROFILING
+        // (counters only: the breeders do not time phases)
+        m_context.getProfiler().print(m_perfFile, record.gen, 1, record.ancestryDepth, record.ancestrySize);
+#endif
+    }
 }
 
 
-void nRun::dumpRemainingLODandKnockout(unsigned int genID, nAgent& a, nGame& game){
-    // if the agent has parents, first dump them
+void nRun::dumpRemainingLODandKnockout(unsigned int genID, nAgent& a){
+    // its unresolved ancestors first, then the agent
     // (this is done to preserve the order in the knockoutfile)
-    if (a.m_parents.size() != 0)
-        dumpRemainingLODandKnockout(genID - 1, *a.m_parents[0], game);    // for mutational inheritance there is only one parent
+    m_ancestry.resolveLineage(genID, a);
+}
+
+
+void nRun::recordAncestor(unsigned int genID, nAgent& a){
     
-    // store this guy to the LOD file
-    m_lodFile << "# Gen no. " << genID
-    << " (agent fitness = " << a.m_fitness
-    << "):" << std::endl;
+    // the lineage came in with immigrants: mark where (in the knockout and analysis files too)
+    std::string marker;
+    if (m_lod->crossing(genID, a, marker)) {
+        *(m_game->m_knockoutOutput) << marker << std::endl;
+        m_analysisQueue->note(marker);
+    }
     
-    a.printGenome(m_lodFile);
+    // store this guy to the LOD file
+    m_lod->write(genID, a);
     
     // perform knockout analysis for the this guy
-    nAgent* origPlayer = game.getPlayer();
+    nAgent* origPlayer = m_game->getPlayer();
+    bool alive = a.m_alive;
     a.m_alive = true;
-    game.updatePlayer(a);
-    *(game.m_knockoutOutput) << "# Gen no. " << genID << ":" << std::endl;
-    game.profilePlayerKnockout();
-    a.m_alive = false;
-    game.updatePlayer(*origPlayer); 
+    m_game->updatePlayer(a);
+    *(m_game->m_knockoutOutput) << "# Gen no. " << genID << ":" << std::endl;
+    m_game->profilePlayerKnockout();
+    a.m_alive = alive;
+    m_game->updatePlayer(*origPlayer); 
     
     // perform analysis after a specified interval
-    if (genID % analysisInterval == 0) {
-        m_analysisFile << genID << "\t";
-        nAnalyzer analyzer(a.m_id, a.m_genome, a.m_fitness, m_analysisFile);
-        analyzer.setRequirements("all");
-        analyzer.run();
-    }
+    if (genID % params.analysisInterval == 0)
+        m_analysisQueue->submit(genID, a.m_id, a.m_genome, a.m_fitness);
     
 }
 
 
 void nRun::close(){
     
+    // wait for the pending analyses
+    m_analysisQueue->flush(true);
     
     // close files
     m_lodFile.close();
     m_knockoutFile.close();
     m_analysisFile.close();
+#ifndef EVONIK_NO_PROFILING
+    m_perfFile.close();
+#endif
+}
+
+
+void nRun::goReplicates(std::string runName, unsigned int firstID, unsigned int replicates,
+                        unsigned int seed, unsigned int numThreads){
+    
+    // a single run in a single thread needs no scheduling
+    if (replicates == 1 && numThreads == 1) {
+        nRun singleRun(runName, firstID, seed);
+        singleRun.go();
+        singleRun.close();
+        return;
+    }
+    
+    nScheduler scheduler(numThreads);
+    
+    if (!params.suppressMessages)
+        std::cout << "Running " << replicates << " replicates on "
+        << scheduler.getNumThreads() << " threads" << std::endl;
+    
+    // each replicate is one job (analyses are queued as more jobs on the way)
+    for (unsigned int i = 0; i < replicates; i++)
+        scheduler.submit(boost::bind(&nRun::goReplicate, runName, firstID + i, seed + i, &scheduler));
+    
+    scheduler.wait();
+}
+
+
+void nRun::goReplicate(std::string runName, unsigned int id, unsigned int seed, nScheduler* scheduler){
+    nRun replicate(runName, id, seed, scheduler);
+    replicate.go();
+    replicate.close();
+}
+
+
+void nRun::reanalyse(std::string runDirectory, unsigned int numThreads){
+    
+    fs::path directory(runDirectory);
+    std::ifstream lodFile((directory/"lod_output.txt").string().c_str());
+    if (!lodFile.is_open()) {
+        std::cerr << "Error in nRun: no lod_output.txt in " << runDirectory << std::endl;
+        exit(1);
+    }
+    std::ofstream analysisFile((directory/"reanalysisData.txt").string().c_str(), std::ios::out | std::ios::trunc);
+    analysisFile << analysisHeader << std::endl;
+    
+    // the brains analysed in the run (or in an earlier reanalysis) are not analysed again
+    boost::scoped_ptr<nAnalysisCache> analysisCache;
+    if (params.cacheAnalyses)
+        analysisCache.reset(new nAnalysisCache((directory/"analysisCache.txt").string()));
+    
+    boost::scoped_ptr<nScheduler> scheduler;
+    if (numThreads != 1)
+        scheduler.reset(new nScheduler(numThreads));
+    
+    {
+        nAnalysisQueue analysisQueue(analysisFile, scheduler.get(), analysisCache.get());
+        
+        // the genomes rebuilt entry by entry
+        unsigned int genID(0), agentID(0);
+        double fitness(0);
+        nGenome genome;
+        std::string marker;
+        while (nLOD::readNext(lodFile, genID, agentID, fitness, genome, &marker)) {
+            if (!marker.empty())
+                analysisQueue.note(marker);
+            if (genID % params.analysisInterval == 0)
+                analysisQueue.submit(genID, agentID, genome, fitness);
+        }
+        
+        analysisQueue.flush(true);
+    }
+    
+    if (!params.suppressMessages && analysisCache)
+        std::cout << "Reanalysed " << runDirectory << " (" << analysisCache->getSize()
+        << " brains cached)" << std::endl;
 }
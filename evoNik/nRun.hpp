@@ -10,18 +10,31 @@
 #define evoNik_run_hpp
 
 #include <string>
+#include <deque>
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/atomic.hpp>
 
 #include "utility.hpp"
+#include "nRunContext.hpp"
+#include "nScheduler.hpp"
+#include "nAncestry.hpp"
 #include "nPopulation.hpp"
+#include "nSteadyState.hpp"
+#include "nAnalyzer.hpp"
+#include "nLOD.hpp"
 
+class nArchipelago;
 
 class nRun{
 public:
     
     
-    // constructor with id (for multiple runs)
-    nRun(std::string runName, unsigned int id = 0)
-    :m_runName(runName), m_id(id){
+    // constructor with id (for multiple runs), random seed
+    // and a scheduler to share the cores with other runs
+    nRun(std::string runName, unsigned int id = 0, unsigned int seed = 0, nScheduler* scheduler = NULL)
+    :m_runName(runName), m_id(id), m_seed(seed), m_context(seed, scheduler), m_game(NULL), m_archipelago(NULL), m_island(0){
         this->init();
     
     }
@@ -34,24 +47,95 @@ public:
     // member functions
     // initialize the run
     void init(void);
-    // start processing
+    // start processing (generation by generation, or steady state, see params.steadyState)
     void go(void);
     // finish LOD for the "best" guy
-    void dumpRemainingLODandKnockout(unsigned int genID, nAgent& a, nGame& g);
+    void dumpRemainingLODandKnockout(unsigned int genID, nAgent& a);
+    // LOD entry, knockout and (at the interval) analysis of an ancestor
+    void recordAncestor(unsigned int genID, nAgent& a);
     // close the run
     void close(void);
+    // evolve as an island of an archipelago (exchanging migrants)
+    void joinArchipelago(nArchipelago& archipelago, unsigned int island)   { m_archipelago = &archipelago; m_island = island; }
+    // experiment directory (holding the run directory)
+    fs::path getDataDirectory(void)                                        { return m_dataDirectory; }
+    
+    // run a number of replicates (ids firstID, firstID+1, ...) concurrently
+    static void goReplicates(std::string runName, unsigned int firstID, unsigned int replicates,
+                             unsigned int seed, unsigned int numThreads = 0);
+    // analyse the line of descent of an earlier run again (every analysisInterval generations,
+    // into reanalysisData.txt), reusing the brain results kept in its analysisCache.txt
+    static void reanalyse(std::string runDirectory, unsigned int numThreads = 1);
     
 private:
     // run name
     std::string m_runName;
     // this run id
     unsigned int m_id;
+    // random seed
+    unsigned int m_seed;
+    // id counters etc. of this run
+    nRunContext m_context;
     // working directory
     fs::path m_thisRunDirectory;
     // run data storage directory
     fs::path m_dataDirectory;
     // LOD, knockout, analysis data and evolution progress files
     std::fstream m_lodFile, m_knockoutFile, m_analysisFile, m_progressFile, m_parameterFile; 
+    // LOD entries (keyframes and edits) written to the LOD file
+    boost::scoped_ptr<nLOD> m_lod;
+#ifndef EVONIK_NO_PROFILING
+    // per-generation phase timing and counters
+    std::fstream m_perfFile;
+#endif
+    // brain results of the analyses (NULL: not kept)
+    boost::scoped_ptr<nAnalysisCache> m_analysisCache;
+    // analyses to be written to the analysis file
+    boost::scoped_ptr<nAnalysisQueue> m_analysisQueue;
+    // the lineage of the evolving population
+    nAncestry m_ancestry;
+    // the game (for knockout profiling) while evolving
+    nGame* m_game;
+    // archipelago this run is an island of (NULL: none) and its index there
+    nArchipelago* m_archipelago;
+    unsigned int m_island;
+    // guards the game (and its maze) while steady-state breeders copy it
+    boost::mutex m_gameMutex;
+    // the game's maze in steady state (shared by the breeders' games) and its id
+    // (the breeders pick up the maze again once it changes)
+    boost::shared_ptr<nMaze> m_maze;
+    boost::atomic<unsigned int> m_mazeID;
+    
+    // a completed steady-state generation, as it was when completed
+    struct generationRecord{
+        unsigned int gen;
+        double averageFitness, maxFitness, gamesPerBirth, cacheHitRate, birthRate;
+        unsigned int ancestryDepth, ancestrySize;
+        // the LOD entries resolved with it (copies: the agents may die before they are recorded)
+        std::vector<std::pair<unsigned int, boost::shared_ptr<nAgent> > > entries;
+    };
+    // LOD entries resolved, not part of a generation record yet (population locked)
+    std::vector<std::pair<unsigned int, boost::shared_ptr<nAgent> > > m_deferredEntries;
+    // generations completed, not recorded yet
+    std::deque<generationRecord> m_pendingGenerations;
+    boost::mutex m_pendingMutex;
+    // held by the one breeder recording the pending generations
+    boost::mutex m_recorderMutex;
+    
+    // evolve in steady state: breed on this thread and the idle workers
+    void goSteadyState(void);
+    // breed newborns until all the births are done (a breeder, numbered)
+    void breed(nSteadyState& population, size_t breeder);
+    // a completed steady-state generation (population locked): statistics and LOD entries
+    // resolved, to be recorded later, out of the lock
+    void snapshotGeneration(nSteadyState* population, unsigned int gen);
+    // keep a copy of a resolved LOD entry for its generation record (population locked)
+    void deferAncestor(unsigned int genID, nAgent& a);
+    // progress, LOD entries and maze updates of the pending generations (unless another
+    // breeder is recording them already, or wait if asked to)
+    void recordGenerations(bool wait = false);
+    // run one replicate (a scheduler job)
+    static void goReplicate(std::string runName, unsigned int id, unsigned int seed, nScheduler* scheduler);
     
 };
 
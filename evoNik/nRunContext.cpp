@@ -0,0 +1,20 @@
+//
+//  nRunContext.cpp
+//  evoNik
+//
+
+#include "nRunContext.hpp"
+
+nRunContext*& nRunContext::active(){
+    static thread_local nRunContext* context = NULL;
+    return context;
+}
+
+
+nRunContext& nRunContext::current(){
+    // process-wide context (for everything outside an explicit run)
+    static nRunContext processContext;
+
+    nRunContext* context = active();
+    return (context != NULL) ? *context : processContext;
+}
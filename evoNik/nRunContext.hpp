@@ -0,0 +1,88 @@
+//
+//  nRunContext.hpp
+//  evoNik
+//
+//  Per-run bookkeeping that used to live in process-wide statics
+//  (agent and generation id counters). Every thread works within
+//  one context at a time; independent runs (replicates) in the same
+//  process get their own.
+//
+
+#ifndef evoNik_nRunContext_hpp
+#define evoNik_nRunContext_hpp
+
+#include <boost/atomic.hpp>
+
+#include "utility.hpp"
+#include "nProfiler.hpp"
+
+class nScheduler;
+
+class nRunContext{
+public:
+
+    // constructor
+    nRunContext(unsigned int seed = 0, nScheduler* scheduler = NULL)
+    : m_seed(seed),
+    m_scheduler(scheduler),
+    m_nextAgentID(0),
+    m_nextGenerationID(0){
+    }
+
+    // member functions
+    // random seed of the run
+    unsigned int getSeed(void)                                { return m_seed; }
+    // scheduler for off-loading work (NULL: do it in place)
+    nScheduler* getScheduler(void)                            { return m_scheduler; }
+    // draw a new agent id
+    unsigned int nextAgentID(void)                            { return m_nextAgentID++; }
+    // draw count consecutive agent ids (the first of them)
+    unsigned int nextAgentIDs(unsigned int count)             { return m_nextAgentID.fetch_add(count); }
+    // draw a new generation id
+    unsigned int nextGenerationID(void)                       { return m_nextGenerationID++; }
+#ifndef EVONIK_NO_PROFILING
+    // phase timers and counters of the run
+    nProfiler& getProfiler(void)                              { return m_profiler; }
+#endif
+
+    // the context of the calling thread
+    static nRunContext& current(void);
+
+    // scoped activation of a context in the calling thread
+    class scope{
+    public:
+        scope(nRunContext& context)
+        : m_previous(active()){
+            active() = &context;
+        }
+        ~scope(){
+            active() = m_previous;
+        }
+    private:
+        nRunContext* m_previous;
+
+        scope(const scope&);
+        scope& operator = (const scope&);
+    };
+
+private:
+    // random seed
+    unsigned int m_seed;
+    // scheduler
+    nScheduler* m_scheduler;
+    // id counters
+    boost::atomic<unsigned int> m_nextAgentID, m_nextGenerationID;
+#ifndef EVONIK_NO_PROFILING
+    // instrumentation
+    nProfiler m_profiler;
+#endif
+
+    // context activated in the calling thread (NULL: the process-wide one)
+    static nRunContext*& active(void);
+
+    // not copyable
+    nRunContext(const nRunContext&);
+    nRunContext& operator = (const nRunContext&);
+};
+
+#endif
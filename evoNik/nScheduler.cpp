@@ -0,0 +1,160 @@
+//
+//  nScheduler.cpp
+//  evoNik
+//
+
+#include <iostream>
+
+#include "nScheduler.hpp"
+
+nScheduler::nScheduler(unsigned int numThreads)
+: m_numThreads(numThreads),
+m_urgentJobs(0),
+m_activeJobs(0),
+m_idleWorkers(0),
+m_stopping(false){
+
+    // one worker per core, if not specified
+    if (m_numThreads == 0)
+        m_numThreads = std::max(1u, boost::thread::hardware_concurrency());
+
+    for (unsigned int i = 0; i < m_numThreads; i++)
+        m_workers.create_thread(boost::bind(&nScheduler::work, this));
+}
+
+
+nScheduler::~nScheduler(){
+    // let the workers finish pending jobs
+    wait();
+
+    {
+        boost::lock_guard<boost::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_jobAvailable.notify_all();
+
+    m_workers.join_all();
+}
+
+
+void nScheduler::submit(boost::function<void()> job, bool urgent){
+    {
+        boost::lock_guard<boost::mutex> lock(m_mutex);
+        if (urgent) {
+            m_jobs.push_front(job);
+            m_urgentJobs++;
+        }
+        else
+            m_jobs.push_back(job);
+    }
+    m_jobAvailable.notify_one();
+}
+
+
+bool nScheduler::runPendingJob(bool urgentOnly){
+    boost::function<void()> job;
+    {
+        boost::lock_guard<boost::mutex> lock(m_mutex);
+        if (m_jobs.empty() || (urgentOnly && m_urgentJobs == 0))
+            return false;
+
+        job = m_jobs.front();
+        m_jobs.pop_front();
+        if (m_urgentJobs > 0)
+            m_urgentJobs--;
+        m_activeJobs++;
+    }
+
+    runJob(job);
+    return true;
+}
+
+
+void nScheduler::wait(){
+    boost::unique_lock<boost::mutex> lock(m_mutex);
+    while (!m_jobs.empty() || m_activeJobs != 0)
+        m_allDone.wait(lock);
+}
+
+
+void nScheduler::forEach(size_t count, boost::function<void (size_t)> task){
+    boost::shared_ptr<loop> l(new loop(count, task));
+
+    // the idle workers join in (ones starting late find nothing left to do)
+    unsigned int helpers;
+    {
+        boost::lock_guard<boost::mutex> lock(m_mutex);
+        helpers = (unsigned int)std::min<size_t>(m_idleWorkers, (count > 0) ? count - 1 : 0);
+    }
+    for (unsigned int i = 0; i < helpers; i++)
+        submit(boost::bind(&nScheduler::runLoop, l), true);
+
+    runLoop(l);
+
+    // wait for the iterations still run by the workers
+    boost::unique_lock<boost::mutex> lock(l->mutex);
+    while (l->done < l->count)
+        l->finished.wait(lock);
+}
+
+
+void nScheduler::runLoop(boost::shared_ptr<loop> l){
+    size_t done = 0;
+    for (size_t i = l->next++; i < l->count; i = l->next++, done++)
+        l->task(i);
+
+    if (done == 0)
+        return;
+
+    boost::lock_guard<boost::mutex> lock(l->mutex);
+    l->done += done;
+    if (l->done == l->count)
+        l->finished.notify_all();
+}
+
+
+void nScheduler::work(){
+    while (true) {
+        boost::function<void()> job;
+        {
+            boost::unique_lock<boost::mutex> lock(m_mutex);
+            m_idleWorkers++;
+            while (m_jobs.empty() && !m_stopping)
+                m_jobAvailable.wait(lock);
+            m_idleWorkers--;
+
+            if (m_jobs.empty())
+                return;
+
+            job = m_jobs.front();
+            m_jobs.pop_front();
+            if (m_urgentJobs > 0)
+                m_urgentJobs--;
+            m_activeJobs++;
+        }
+
+        runJob(job);
+    }
+}
+
+
+void nScheduler::runJob(boost::function<void()>& job){
+    // a failed job (an analysis or a replicate) leaves its waiters blocked: give up the run
+    try {
+        job();
+    } catch (std::exception& e) {
+        std::cerr << "Error in nScheduler: job failed (" << e.what() << ")" << std::endl;
+        exit(1);
+    } catch (const char* e) {
+        std::cerr << "Error in nScheduler: job failed (" << e << ")" << std::endl;
+        exit(1);
+    } catch (...) {
+        std::cerr << "Error in nScheduler: job failed" << std::endl;
+        exit(1);
+    }
+
+    boost::lock_guard<boost::mutex> lock(m_mutex);
+    m_activeJobs--;
+    if (m_jobs.empty() && m_activeJobs == 0)
+        m_allDone.notify_all();
+}
@@ -0,0 +1,88 @@
+//
+//  nScheduler.hpp
+//  evoNik
+//
+//  A simple pool of worker threads sharing one job queue.
+//  Used to balance independent runs (replicates) and their
+//  analysis work across the available cores, and to share loops
+//  of independent iterations (forEach) with the idle workers.
+//
+
+#ifndef evoNik_nScheduler_hpp
+#define evoNik_nScheduler_hpp
+
+#include <deque>
+
+#include <boost/atomic.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "utility.hpp"
+
+class nScheduler{
+public:
+
+    // constructor with number of worker threads (0: one per core)
+    nScheduler(unsigned int numThreads = 0);
+
+    // destructor (finishes pending jobs and joins the workers)
+    ~nScheduler();
+
+    // member functions
+    // get number of worker threads
+    unsigned int getNumThreads(void)                       { return m_numThreads; }
+    // queue a job (urgent jobs are served before the others)
+    void submit(boost::function<void()> job, bool urgent = false);
+    // run one pending job (optionally an urgent one only) in the calling thread (false if none was pending)
+    bool runPendingJob(bool urgentOnly = false);
+    // wait until all submitted jobs are done
+    void wait(void);
+    // run task(0) to task(count - 1) in the calling thread and the workers joining in
+    // (returns once all are done; safe within a job, unlike wait)
+    void forEach(size_t count, boost::function<void (size_t)> task);
+
+private:
+    // number of workers
+    unsigned int m_numThreads;
+    // workers
+    boost::thread_group m_workers;
+    // pending jobs (the urgent ones first)
+    std::deque<boost::function<void()> > m_jobs;
+    unsigned int m_urgentJobs;
+    // jobs being run at the moment
+    unsigned int m_activeJobs;
+    // workers waiting for a job
+    unsigned int m_idleWorkers;
+    // shutting down
+    bool m_stopping;
+
+    // synchronization
+    boost::mutex m_mutex;
+    boost::condition_variable m_jobAvailable, m_allDone;
+
+    // iterations of a forEach, claimed one by one
+    struct loop{
+        loop(size_t count, boost::function<void (size_t)> task)
+        : count(count), task(task), next(0), done(0){
+        }
+        size_t count;
+        boost::function<void (size_t)> task;
+        boost::atomic<size_t> next;
+        // iterations done (guarded by mutex)
+        size_t done;
+        boost::mutex mutex;
+        boost::condition_variable finished;
+    };
+
+    // worker thread body
+    void work(void);
+    // run the given job and book-keep
+    void runJob(boost::function<void()>& job);
+    // claim and run iterations of a loop until none is left
+    static void runLoop(boost::shared_ptr<loop> l);
+
+    // not copyable
+    nScheduler(const nScheduler&);
+    nScheduler& operator = (const nScheduler&);
+};
+
+#endif
@@ -0,0 +1,76 @@
+//
+//  nSelection.cpp
+//  evoNik
+//
+
+#include <algorithm>
+
+#include "nSelection.hpp"
+
+nSelector* nSelector::create(const std::string& method){
+    if (method == "roulette")
+        return new nRouletteSelector;
+    if (method == "tournament")
+        return new nTournamentSelector;
+    if (method == "rank")
+        return new nRankSelector;
+    return NULL;
+}
+
+
+unsigned int nWeightedSelector::select(){
+
+    // drop a needle between 0 and the total weight
+    double dropper = genUniRand(0, m_prefixSums.back());
+
+    // the first agent whose running sum reaches it
+    std::vector<double>::iterator it = std::lower_bound(m_prefixSums.begin(), m_prefixSums.end(), dropper);
+    if (it == m_prefixSums.end())
+        it--;
+
+    return (unsigned int)(it - m_prefixSums.begin());
+}
+
+
+void nRouletteSelector::prepare(const std::vector<nAgent*>& members){
+
+    m_prefixSums.resize(members.size());
+
+    // consider only those agents with fitness more than
+    // a fraction of the max fitness in the generation
+    double threshold = params.purgeFraction*members[0]->m_fitness;
+    double total(0.0);
+
+    for (size_t i = 0; i < members.size(); i++) {
+        if (members[i]->m_fitness >= threshold)
+            total += members[i]->m_fitness;
+        m_prefixSums[i] = total;
+    }
+}
+
+
+void nRankSelector::prepare(const std::vector<nAgent*>& members){
+
+    m_prefixSums.resize(members.size());
+
+    double total(0.0);
+    for (size_t i = 0; i < members.size(); i++) {
+        total += members.size() - i;
+        m_prefixSums[i] = total;
+    }
+}
+
+
+unsigned int nTournamentSelector::select(){
+
+    unsigned int winner = 0;
+
+    for (unsigned int i = 0; i < m_size; i++) {
+        unsigned int competitor = std::min((unsigned int)genUniRand(0, m_members->size()),
+                                           (unsigned int)m_members->size() - 1);
+        if (i == 0 || (*m_members)[competitor]->m_fitness > (*m_members)[winner]->m_fitness)
+            winner = competitor;
+    }
+
+    return winner;
+}
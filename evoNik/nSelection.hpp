@@ -0,0 +1,84 @@
+//
+//  nSelection.hpp
+//  evoNik
+//
+//  Parent selection schemes. A selector is prepared once per generation
+//  from its (ranked) members and then draws parents by index:
+//  - roulette: fitness proportionate, binary search in the prefix sums
+//    (agents below purgeFraction of the max. fitness are never drawn)
+//  - tournament: the fittest of tournamentSize uniformly drawn agents
+//  - rank: linear ranking, the best of N agents weighs N, the worst 1
+//
+
+#ifndef evoNik_nSelection_hpp
+#define evoNik_nSelection_hpp
+
+#include <vector>
+#include <string>
+
+#include "utility.hpp"
+#include "nAgent.hpp"
+
+class nSelector{
+public:
+
+    // destructor
+    virtual ~nSelector(){
+    }
+
+    // member functions
+    // set up the selection among the members of a generation
+    virtual void prepare(const std::vector<nAgent*>& members) = 0;
+    // draw a parent (index into the members)
+    virtual unsigned int select(void) = 0;
+
+    // selector for a method name (NULL if unknown)
+    static nSelector* create(const std::string& method = params.selectionMethod);
+};
+
+
+// draw by weight (O(log N) per draw)
+class nWeightedSelector : public nSelector{
+public:
+    unsigned int select(void);
+
+protected:
+    // running sums of the weights
+    std::vector<double> m_prefixSums;
+};
+
+
+// fitness proportionate (roulette wheel) selection
+class nRouletteSelector : public nWeightedSelector{
+public:
+    void prepare(const std::vector<nAgent*>& members);
+};
+
+
+// linear rank selection (members ranked, the best first)
+class nRankSelector : public nWeightedSelector{
+public:
+    void prepare(const std::vector<nAgent*>& members);
+};
+
+
+// tournament selection
+class nTournamentSelector : public nSelector{
+public:
+
+    // constructor with tournament size
+    nTournamentSelector(unsigned int size = params.tournamentSize)
+    : m_size(size), m_members(NULL){
+    }
+
+    void prepare(const std::vector<nAgent*>& members)          { m_members = &members; }
+    unsigned int select(void);
+
+private:
+    // agents per tournament
+    unsigned int m_size;
+    // the competitors
+    const std::vector<nAgent*>* m_members;
+};
+
+#endif
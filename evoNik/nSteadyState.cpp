@@ -0,0 +1,127 @@
+//
+//  nSteadyState.cpp
+//  evoNik
+//
+
+#include <algorithm>
+
+#include "nSteadyState.hpp"
+
+nSteadyState::nSteadyState(const std::vector<nAgent*>& founders, nAncestry& ancestry, unsigned long births)
+: m_members(founders),
+m_ancestry(&ancestry),
+m_selector(nSelector::create()),
+m_birthsLeft(births),
+m_births(0),
+m_gamesPlayed(0),
+m_cacheLookups(0),
+m_cacheHits(0),
+m_generationStart(boost::chrono::steady_clock::now()),
+m_birthRate(0){
+
+    if (m_members.empty()) {
+        std::cerr << "Error in nSteadyState: no founders!" << std::endl;
+        exit(1);
+    }
+
+    // ranked, the fittest first
+    std::stable_sort(m_members.begin(), m_members.end(), fitterThan());
+}
+
+
+bool nSteadyState::conceive(std::vector<nAgent*>& newborns){
+
+    newborns.clear();
+
+    boost::lock_guard<boost::mutex> lock(m_mutex);
+
+    if (m_birthsLeft == 0)
+        return false;
+
+    // parents selected among the members as they are now
+    m_selector->prepare(m_members);
+    nAgent* mother = m_members[m_selector->select()];
+
+    if (params.crossOverOn) {
+        nAgent* father = m_members[m_selector->select()];
+        std::pair<nAgent, nAgent> kids = mother->crossOver(*father);
+        newborns.push_back(new nAgent(std::move(kids.first)));
+        // (the last birth may leave room for one only)
+        if (m_birthsLeft > 1)
+            newborns.push_back(new nAgent(std::move(kids.second)));
+    }
+    else
+        newborns.push_back(new nAgent(mother->inheriteGenome()));
+    PROFILE_COUNT(COUNT_AGENTS_ALLOCATED, newborns.size());
+
+    for (std::vector<nAgent*>::iterator it = newborns.begin(); it != newborns.end(); it++) {
+
+        // one generation younger than its youngest parent
+        unsigned int generation = 0;
+        for (size_t i = 0; i < (*it)->m_parents.size(); i++)
+            generation = std::max(generation, (*it)->m_parents[i]->m_generation + 1);
+
+        m_ancestry->add(*(*it), generation);
+        m_newborns.push_back(*it);
+    }
+
+    m_birthsLeft -= newborns.size();
+    return true;
+}
+
+
+void nSteadyState::insert(nAgent& newborn, unsigned int gamesPlayed, unsigned long cacheLookups, unsigned long cacheHits){
+
+    boost::lock_guard<boost::mutex> lock(m_mutex);
+
+    std::vector<nAgent*>::iterator born = std::find(m_newborns.begin(), m_newborns.end(), &newborn);
+    if (born == m_newborns.end()) {
+        std::cerr << "Error in nSteadyState: agent # " << newborn.m_id << " was not conceived here!" << std::endl;
+        exit(1);
+    }
+    m_newborns.erase(born);
+
+    // the least fit member dies (to the ancestry, which frees it)
+    nAgent* dead = m_members.back();
+    m_members.pop_back();
+    m_ancestry->retire(*dead);
+
+    // the newborn ranked in, before the members as fit as it (of the least fit,
+    // the one longest in the population dies first)
+    m_members.insert(std::lower_bound(m_members.begin(), m_members.end(), &newborn, fitterThan()), &newborn);
+
+    m_gamesPlayed += gamesPlayed;
+    m_cacheLookups += cacheLookups;
+    m_cacheHits += cacheHits;
+
+    // a generation completed
+    if (++m_births % params.populationSize == 0) {
+        boost::chrono::steady_clock::time_point now = boost::chrono::steady_clock::now();
+        double seconds = boost::chrono::duration<double>(now - m_generationStart).count();
+        m_birthRate = (seconds > 0) ? params.populationSize / seconds : 0;
+
+        if (m_generationHandler)
+            m_generationHandler((unsigned int)(m_births / params.populationSize));
+
+        m_gamesPlayed = m_cacheLookups = m_cacheHits = 0;
+        m_generationStart = boost::chrono::steady_clock::now();
+    }
+}
+
+
+double nSteadyState::getAverageFitness(){
+    double sum(0);
+    for (std::vector<nAgent*>::iterator it = m_members.begin(); it != m_members.end(); it++)
+        sum += (*it)->m_fitness;
+    return sum / m_members.size();
+}
+
+
+unsigned int nSteadyState::getLiveGeneration(){
+    unsigned int oldest = m_members.front()->m_generation;
+    for (std::vector<nAgent*>::iterator it = m_members.begin(); it != m_members.end(); it++)
+        oldest = std::min(oldest, (*it)->m_generation);
+    for (std::vector<nAgent*>::iterator it = m_newborns.begin(); it != m_newborns.end(); it++)
+        oldest = std::min(oldest, (*it)->m_generation);
+    return oldest;
+}
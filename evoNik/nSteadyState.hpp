@@ -0,0 +1,100 @@
+//
+//  nSteadyState.hpp
+//  evoNik
+//
+//  The live population of a steady-state run (see params.steadyState).
+//  There are no generations to wait for: any number of threads breed
+//  at once. A newborn is conceived from parents selected among the live
+//  members (conceive), then varied, built and evaluated by its thread on
+//  its own, and finally takes the place of the least fit member (insert).
+//  The members are kept ranked, the fittest first.
+//
+//  In the lineage a newborn is one generation younger than its youngest
+//  parent, so every generation of the ancestry descends from the one
+//  before, as nAncestry needs to resolve the line of descent. For
+//  progress, a generation is populationSize births.
+//
+
+#ifndef evoNik_nSteadyState_hpp
+#define evoNik_nSteadyState_hpp
+
+#include <vector>
+
+#include <boost/chrono.hpp>
+#include <boost/function.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include "utility.hpp"
+#include "nAgent.hpp"
+#include "nAncestry.hpp"
+#include "nSelection.hpp"
+
+class nSteadyState{
+public:
+
+    // receives the number of every completed generation (populationSize births),
+    // with the population locked
+    typedef boost::function<void (unsigned int)> generationHandler;
+
+    // constructor with the (evaluated) founders, registered with the ancestry, and the births to come
+    nSteadyState(const std::vector<nAgent*>& founders, nAncestry& ancestry, unsigned long births);
+
+    // member functions
+    // set the receiver of completed generations
+    void setGenerationHandler(generationHandler handler)        { m_generationHandler = handler; }
+    // conceive the next newborns from parents among the live members: one, or two by cross-over
+    // (not mutated yet, brains not built); false once all the births are conceived
+    bool conceive(std::vector<nAgent*>& newborns);
+    // a newborn, evaluated, replaces the least fit member (with the games played and the
+    // fitness cache lookups of its evaluation)
+    void insert(nAgent& newborn, unsigned int gamesPlayed, unsigned long cacheLookups, unsigned long cacheHits);
+
+    // while locked (in the generation handler, or once the breeding is over):
+    // the fittest member
+    nAgent* getElite(void)                                      { return m_members.front(); }
+    // fitness statistics of the live members
+    double getAverageFitness(void);
+    double getMaxFitness(void)                                  { return m_members.front()->m_fitness; }
+    // games per newborn, fitness cache hit rate and births per second, over the last generation
+    double getGamesPerBirth(void)                               { return (double)m_gamesPlayed / params.populationSize; }
+    double getCacheHitRate(void)                                { return (m_cacheLookups == 0) ? 0 : (double)m_cacheHits / m_cacheLookups; }
+    double getBirthRate(void)                                   { return m_birthRate; }
+    // the oldest generation of the ancestry with an agent alive (or being born):
+    // the older ones are ancestors only, and may be resolved
+    unsigned int getLiveGeneration(void);
+
+private:
+    // the members, the fittest first
+    std::vector<nAgent*> m_members;
+    // newborns conceived, not inserted yet
+    std::vector<nAgent*> m_newborns;
+    // ancestry the members are registered with
+    nAncestry* m_ancestry;
+    // parent selection
+    boost::scoped_ptr<nSelector> m_selector;
+    // births still to be conceived, births inserted
+    unsigned long m_birthsLeft, m_births;
+    // of the current generation: games played and fitness cache lookups
+    unsigned long m_gamesPlayed, m_cacheLookups, m_cacheHits;
+    // start of the current generation, births per second of the last one
+    boost::chrono::steady_clock::time_point m_generationStart;
+    double m_birthRate;
+    // completed generation receiver
+    generationHandler m_generationHandler;
+
+    // synchronization
+    boost::mutex m_mutex;
+
+    // the fitter first
+    struct fitterThan{
+        bool operator ()(const nAgent* a1, const nAgent* a2){
+            return *a2 < *a1;
+        }
+    };
+
+    // not copyable
+    nSteadyState(const nSteadyState&);
+    nSteadyState& operator = (const nSteadyState&);
+};
+
+#endif
@@ -0,0 +1,112 @@
+//
+//  nTransitionMatrix.cpp
+//  evoNik
+//
+
+#include "nTransitionMatrix.hpp"
+
+nTransitionMatrix::nTransitionMatrix(const nAgent& agent, unsigned long maxTransitions)
+: m_nodes(params.maxNodes){
+
+    // a wide brain has too many states to list: not valid (sample it instead)
+    if (m_nodes > exhaustiveNodesLimit)
+        return;
+    m_rows.resize((size_t)1 << m_nodes);
+
+    // fired as the agent fires them: the winner output of every row, or all of them
+    bool deterministic = agent.m_stochasticUnits.empty();
+    unsigned long transitions(0);
+
+    for (unsigned long state = 0; state < m_rows.size(); state++) {
+
+        // distribution of the state as the units fire one after the other
+        unsigned long masked = state;
+        applyMask(masked, agent.m_maskedNode, agent.m_maskValue);
+        std::map<unsigned long, double> current, next;
+        current[masked] = 1.0;
+
+        for (std::vector<nHMMUnit>::const_iterator unit = agent.m_hmms.begin(); unit != agent.m_hmms.end(); unit++) {
+
+            unsigned long outputMask = 0;
+            for (size_t i = 0; i < unit->m_outputs.size(); i++)
+                outputMask |= (1UL << unit->m_outputs[i]);
+
+            next.clear();
+            for (std::map<unsigned long, double>::iterator it = current.begin(); it != current.end(); it++) {
+
+                // input row (the first input is the most significant bit)
+                unsigned int r = 0;
+                for (size_t i = 0; i < unit->m_inputs.size(); i++)
+                    r = (r << 1) | ((it->first >> unit->m_inputs[i])&1);
+                const std::vector<unsigned int>& hmm = unit->m_hmm[r];
+
+                size_t first = deterministic ? std::max_element(hmm.begin(), hmm.end()) - hmm.begin() : 0;
+                size_t last = deterministic ? first + 1 : hmm.size();
+
+                for (size_t c = first; c < last; c++) {
+                    if (hmm[c] == 0)
+                        continue;
+
+                    // output code on the output nodes
+                    unsigned long outState = it->first & ~outputMask;
+                    for (size_t i = 0; i < unit->m_outputs.size(); i++)
+                        if ((c >> i)&1)
+                            outState |= (1UL << unit->m_outputs[i]);
+                    applyMask(outState, agent.m_maskedNode, agent.m_maskValue);
+
+                    next[outState] += deterministic ? it->second : it->second * hmm[c] / unit->m_sums[r];
+                }
+            }
+            current.swap(next);
+        }
+
+        // too many: give up
+        transitions += current.size();
+        if (transitions > maxTransitions) {
+            m_rows.clear();
+            return;
+        }
+
+        m_rows[state].assign(current.begin(), current.end());
+    }
+}
+
+
+nTransitionMatrix nTransitionMatrix::then(const nTransitionMatrix& one, unsigned long maxTransitions) const{
+
+    nTransitionMatrix product(m_nodes);
+    unsigned long transitions(0);
+
+    std::map<unsigned long, double> distribution;
+    for (size_t state = 0; state < m_rows.size(); state++) {
+        distribution.clear();
+        for (row::const_iterator it = m_rows[state].begin(); it != m_rows[state].end(); it++)
+            for (row::const_iterator jt = one.m_rows[it->first].begin(); jt != one.m_rows[it->first].end(); jt++)
+                distribution[jt->first] += it->second * jt->second;
+
+        // too many: give up
+        transitions += distribution.size();
+        if (transitions > maxTransitions) {
+            product.m_rows.clear();
+            break;
+        }
+
+        product.m_rows[state].assign(distribution.begin(), distribution.end());
+    }
+
+    return product;
+}
+
+
+MT_WEIGHTED_TRANSITION_TABLE nTransitionMatrix::getTransitionTable(const std::vector<size_t>& nodes) const{
+
+    // (the other nodes summed out)
+    MT_WEIGHTED_TRANSITION_TABLE table;
+    for (size_t state = 0; state < m_rows.size(); state++) {
+        std::map<size_t, double>& next = table[projectState(state, nodes)];
+        for (row::const_iterator it = m_rows[state].begin(); it != m_rows[state].end(); it++)
+            next[projectState(it->first, nodes)] += it->second;
+    }
+
+    return table;
+}
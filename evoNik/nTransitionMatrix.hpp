@@ -0,0 +1,59 @@
+//
+//  nTransitionMatrix.hpp
+//  evoNik
+//
+//  The exact transition probabilities of a brain: for every brain state
+//  the distribution of the next state, worked out from the transition
+//  tables of the HMM units (fired one after the other, in m_hmms order,
+//  as nAgent::updateBrain does) instead of sampled by a brain scan. Rows
+//  are sparse: a deterministic brain has one next state per state. A
+//  matrix of more than exhaustiveNodesLimit nodes, or that would hold more
+//  than a given number of transitions (non-zero entries), is given up, and
+//  is not valid.
+//
+
+#ifndef evoNik_nTransitionMatrix_hpp
+#define evoNik_nTransitionMatrix_hpp
+
+#include <map>
+#include <vector>
+
+#include "utility.hpp"
+#include "nAgent.hpp"
+#include "ModularityToolset/ModularityToolset.h"
+
+class nTransitionMatrix{
+public:
+
+    // a row: (next state, probability), ordered by state
+    typedef std::vector<std::pair<unsigned long, double> > row;
+
+    // constructor from the (built) brain of an agent
+    nTransitionMatrix(const nAgent& agent, unsigned long maxTransitions = exactTransitionsLimit);
+
+    // member functions
+    // is it a complete matrix
+    bool isValid(void) const                                     { return !m_rows.empty(); }
+    // number of nodes (the matrix has 2^nodes rows)
+    unsigned int getNodes(void) const                            { return m_nodes; }
+    // the distribution of the next state
+    const row& getRow(unsigned long state) const                 { return m_rows[state]; }
+    // transitions over one more time step (this, then one)
+    nTransitionMatrix then(const nTransitionMatrix& one, unsigned long maxTransitions = exactTransitionsLimit) const;
+    // as weighted transitions (every state equally likely to start from) of the given nodes for the ModularityToolset
+    MT_WEIGHTED_TRANSITION_TABLE getTransitionTable(const std::vector<size_t>& nodes) const;
+
+private:
+    // number of nodes
+    unsigned int m_nodes;
+    // rows (indexed by state)
+    std::vector<row> m_rows;
+
+    // empty matrix of a number of nodes
+    nTransitionMatrix(unsigned int nodes)
+    : m_nodes(nodes),
+    m_rows((size_t)1 << nodes){
+    }
+};
+
+#endif
@@ -29,6 +29,7 @@
 #include <boost/algorithm/string.hpp>
 #include <boost/assign/std/vector.hpp>
 #include <boost/random.hpp>
+#include <boost/functional/hash.hpp>
 #include <boost/iostreams/filtering_stream.hpp>
 #include <boost/iostreams/filter/gzip.hpp>
 #include <boost/iostreams/copy.hpp>
@@ -37,7 +38,6 @@
 
 
 #include "constants.hpp"
-#include "nDijkstra.hpp"
 
 namespace fs = boost::filesystem;
 namespace pt = boost::posix_time;
@@ -81,11 +81,52 @@ struct position{
 };
 
 
+// random number engine
+typedef boost::mt19937 nRandomEngine;
+
+// the engine currently serving random numbers to the calling thread
+// (every thread starts with its own, see nRandomStream for scoped streams)
+inline nRandomEngine*& currentRandomEngine(void){
+    static thread_local nRandomEngine threadEngine((unsigned int)time(NULL) ^
+                                                   (unsigned int)boost::hash<boost::thread::id>()(boost::this_thread::get_id()));
+    static thread_local nRandomEngine* engine = &threadEngine;
+    return engine;
+}
+
+// seed the engine currently serving the calling thread
+inline void seedRandom(unsigned int seed){
+    currentRandomEngine()->seed(seed);
+}
+
+// a scoped random number stream:
+// while alive, the calling thread draws all its random numbers from it
+// (isolates replicates and tasks from each other's random state)
+class nRandomStream{
+public:
+    nRandomStream(unsigned int seed)
+    : m_engine(seed),
+    m_previous(currentRandomEngine()){
+        currentRandomEngine() = &m_engine;
+    }
+    
+    ~nRandomStream(){
+        currentRandomEngine() = m_previous;
+    }
+    
+private:
+    nRandomEngine m_engine;
+    nRandomEngine* m_previous;
+    
+    // not copyable
+    nRandomStream(const nRandomStream&);
+    nRandomStream& operator = (const nRandomStream&);
+};
+
+
 inline void init(void){
-    srand((unsigned int)time(NULL));
-    rand();
+    seedRandom((unsigned int)time(NULL));
 
-    if (suppressMessages){
+    if (params.suppressMessages){
         std::cout << "Warning: Message suppression is set to \"true\" " << std::endl;
         std::cout << "Warning: All messages will be suppressed henceforth!" << std::endl;
         std::cout << "Warning: This will not affect messaging Errors, if any" << std::endl;
@@ -109,29 +150,47 @@ inline std::string dateTimeStamp(bool fractional =true) {
 }
 
 
+inline unsigned int genRandInt(void){
+    return (*currentRandomEngine())();
+}
+
+
 inline double genUniRand(double a, double b){       
-    return a + (b-a)*((double)rand() / (double)RAND_MAX);
+    return a + (b-a)*((double)genRandInt() / (double)nRandomEngine::max());
 }
 
 
 inline void applyMask(unsigned long& state, int bitPosition, bool zeroOrOne){
+    // no node masked
+    if (bitPosition < 0)
+        return;
     // if mask value to 1
     if (zeroOrOne)
-        state |= (1 << bitPosition );
+        state |= (1UL << bitPosition );
     else // if value to 0
-        state &= ~(1 << bitPosition);
+        state &= ~(1UL << bitPosition);
 }
 
 inline void applyBit(unsigned long& state, int bitPosition, bool zeroOrOne){
     applyMask(state, bitPosition, zeroOrOne);
 }
 
-inline void applyBit(unsigned int& state, int bitPosition, bool zeroOrOne){
+// (any other word, e.g. a maze cell: shifted in that word, not in an int)
+template<typename T>
+inline void applyBit(T& state, int bitPosition, bool zeroOrOne){
     // if mask value to 1
     if (zeroOrOne)
-        state |= (1 << bitPosition );
+        state |= ((T)1 << bitPosition );
     else // if value to 0
-        state &= ~(1 << bitPosition);
+        state &= ~((T)1 << bitPosition);
+}
+
+inline unsigned long projectState(unsigned long state, const std::vector<size_t>& nodes){
+    // the given nodes of a state (node nodes[i] as bit i)
+    unsigned long projected = 0;
+    for (size_t i = 0; i < nodes.size(); i++)
+        projected |= ((state >> nodes[i]) & 1UL) << i;
+    return projected;
 }
 
 inline int hammingDistance(position pos1, position pos2){